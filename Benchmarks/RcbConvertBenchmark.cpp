@@ -0,0 +1,91 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+// Microbenchmark for the RCB sample conversion kernels.
+// Prints ns/packet for every channel count the RCB can stream and every kernel this CPU supports.
+
+#include "RcbConvert.h"
+#include "RcbPacket.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace RcbWifiNode;
+
+int main(int argc, char* argv[])
+{
+	const int numIterations = argc > 1 ? atoi(argv[1]) : 200000;
+	const RcbSimdLevel levels[] = { RcbSimdLevel::SCALAR, RcbSimdLevel::SSE2, RcbSimdLevel::AVX2, RcbSimdLevel::NEON };
+	bool ok = true;
+	volatile float sink = 0;
+
+	printf("best kernel: %s\n", getSimdLevelName(getBestSimdLevel()));
+	printf("%8s %8s %8s %12s %12s\n", "channels", "samples", "kernel", "ns/packet", "ns/sample");
+
+	for (int format = 0; format < RCB_NUM_PACKET_FORMATS; format++)
+	{
+		int numChannels = RCB_CHANNEL_COUNTS[format];
+		int numSamples = RCB_SAMPLES_PER_PACKET[format];
+
+		std::vector<uint16_t> packet(rcbPacketBytes(numChannels, numSamples) / 2);
+		for (size_t i = 0; i < packet.size(); i++)
+			packet[i] = uint16_t(rand());
+
+		const uint16_t* src = packet.data() + RCB_HEADER_WORDS + RCB_FRAME_AUX_WORDS;
+		std::vector<float> expected(numChannels * numSamples);
+		std::vector<float> out(numChannels * numSamples);
+
+		getConvertFunction(RcbSimdLevel::SCALAR)(src, rcbFrameWords(numChannels), expected.data(), numChannels,
+			numSamples, numChannels, 0.195f, 32768);
+
+		for (RcbSimdLevel level : levels)
+		{
+			RcbConvertFunction convert = getConvertFunction(level);
+			if (convert == nullptr)
+				continue;
+
+			convert(src, rcbFrameWords(numChannels), out.data(), numChannels, numSamples, numChannels, 0.195f, 32768);
+			if (out != expected)
+			{
+				printf("%s kernel output mismatch at %d channels\n", getSimdLevelName(level), numChannels);
+				ok = false;
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			for (int n = 0; n < numIterations; n++)
+			{
+				convert(src, rcbFrameWords(numChannels), out.data(), numChannels, numSamples, numChannels, 0.195f, 32768);
+				sink = sink + out[n % out.size()];  // keep the compiler from dropping the loop
+			}
+			auto end = std::chrono::steady_clock::now();
+
+			double ns = std::chrono::duration<double, std::nano>(end - start).count() / numIterations;
+			printf("%8d %8d %8s %12.1f %12.3f\n", numChannels, numSamples, getSimdLevelName(level), ns, ns / numSamples);
+		}
+	}
+
+	return ok ? 0 : 1;
+}
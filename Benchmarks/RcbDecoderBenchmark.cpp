@@ -0,0 +1,101 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+// Compares the generic packet decoder against the decoders specialized per channel count and aux state.
+
+#include "RcbDecoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace RcbWifiNode;
+
+static double timeDecoder(RcbDecodeFunction decode, const uint16_t* packet, float* out, RcbDecoderState& state, int numIterations)
+{
+	volatile float sink = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int n = 0; n < numIterations; n++)
+	{
+		decode(packet, out, state);
+		sink = sink + out[n % state.numChannels];  // keep the compiler from dropping the loop
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::nano>(end - start).count() / numIterations;
+}
+
+int main(int argc, char* argv[])
+{
+	const int numIterations = argc > 1 ? atoi(argv[1]) : 200000;
+	bool ok = true;
+
+	printf("%8s %8s %4s %14s %14s %8s\n", "channels", "samples", "aux", "generic ns/pkt", "special ns/pkt", "speedup");
+
+	for (int format = 0; format < RCB_NUM_PACKET_FORMATS; format++)
+	{
+		for (int aux = 0; aux < 2; aux++)
+		{
+			RcbDecoderState state;
+			state.numChannels = RCB_CHANNEL_COUNTS[format];
+			state.numSamples = RCB_SAMPLES_PER_PACKET[format];
+			state.auxEnabled = aux == 1;
+
+			std::vector<uint16_t> packet(rcbPacketBytes(state.numChannels, state.numSamples) / 2);
+			for (size_t i = 0; i < packet.size(); i++)
+				packet[i] = uint16_t(rand());
+			packet[16] = 0x0200;  // aux phase 2
+
+			std::vector<float> expected(state.numChannels * state.numSamples);
+			std::vector<float> out(state.numChannels * state.numSamples);
+
+			RcbDecodeFunction specialized = getSpecializedDecoder(state.numChannels, state.numSamples, state.auxEnabled);
+
+			RcbDecoderState genericState = state;
+			decodePacketGeneric(packet.data(), expected.data(), genericState);
+			RcbDecoderState check = state;
+			specialized(packet.data(), out.data(), check);
+
+			bool sameAux = !state.auxEnabled || (check.auxFirstPhase == genericState.auxFirstPhase
+				&& std::equal(check.auxSlots, check.auxSlots + state.numSamples, genericState.auxSlots));
+
+			if (out != expected || !sameAux)
+			{
+				printf("specialized decoder output mismatch at %d channels, aux %d\n", state.numChannels, aux);
+				ok = false;
+			}
+
+			double generic = timeDecoder(decodePacketGeneric, packet.data(), out.data(), state, numIterations);
+			double special = timeDecoder(specialized, packet.data(), out.data(), state, numIterations);
+
+			printf("%8d %8d %4s %14.1f %14.1f %7.2fx\n", state.numChannels, state.numSamples, aux ? "on" : "off",
+				generic, special, generic / special);
+		}
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,395 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+// Cost of the on-host filter bank and re-referencing for every channel count, as ns per sample and
+// share of one core at 30 kS/s, and a check of their output: passband gain, notch depth and
+// high-pass attenuation, common-mode removal by CAR and median, and the spikes and thresholds found
+// by spike detection in noise, and the passband, alias rejection and sample alignment of LFP decimation.
+
+#include "RcbDecimator.h"
+#include "RcbFilterBank.h"
+#include "RcbPacket.h"
+#include "RcbReference.h"
+#include "RcbSpikeDetector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace RcbWifiNode;
+
+static const double SAMPLE_RATE = 30000.0;
+
+/** Gain in dB of one channel of the bank at hz, after the start transient */
+static double measureGain(const RcbFilterSettings& settings, double hz)
+{
+	RcbFilterBank bank;
+	bank.setup(settings, SAMPLE_RATE, 1);
+
+	const int numFrames = int(SAMPLE_RATE);
+	std::vector<float> signal(numFrames);
+	for (int f = 0; f < numFrames; f++)
+		signal[f] = float(std::sin(2.0 * 3.14159265358979323846 * hz * f / SAMPLE_RATE));
+
+	bank.process(signal.data(), 1, numFrames);
+
+	double in = 0, out = 0;
+	for (int f = numFrames / 2; f < numFrames; f++)
+	{
+		double x = std::sin(2.0 * 3.14159265358979323846 * hz * f / SAMPLE_RATE);
+		in += x * x;
+		out += double(signal[f]) * signal[f];
+	}
+
+	return 10.0 * std::log10(out / in);
+}
+
+/**
+    Decimates a sine of hz by factor and returns the output gain in dB, after the start transient.
+    alignError gets the largest difference between an output sample and the input at the sample it is centred on.
+*/
+static double measureDecimation(int factor, double hz, double& alignError)
+{
+	const int numFrames = int(SAMPLE_RATE) * 2, blockSize = 630;
+	RcbDecimator decimator;
+	decimator.setup(factor, 1, blockSize);
+
+	std::vector<float> signal(numFrames);
+	std::vector<long long> sampleNumbers(numFrames);
+	std::vector<double> timestamps(numFrames);
+	for (int f = 0; f < numFrames; f++)
+	{
+		signal[f] = float(std::sin(2.0 * 3.14159265358979323846 * hz * f / SAMPLE_RATE));
+		sampleNumbers[f] = f;
+		timestamps[f] = f / SAMPLE_RATE;
+	}
+
+	double in = 0, out = 0;
+	alignError = 0;
+
+	for (int f = 0; f < numFrames; f += blockSize)
+	{
+		decimator.process(signal.data() + f, 1, std::min(blockSize, numFrames - f), sampleNumbers.data() + f, timestamps.data() + f, SAMPLE_RATE);
+
+		for (int i = 0; i < decimator.getNumOutput(); i++)
+		{
+			long long centre = decimator.getSampleNumbers()[i] * factor;
+			if (centre < numFrames / 2)
+				continue;
+
+			double x = std::sin(2.0 * 3.14159265358979323846 * hz * centre / SAMPLE_RATE);
+			double y = decimator.getData()[i];
+			in += x * x;
+			out += y * y;
+			alignError = std::max(alignError, std::fabs(y - x) + std::fabs(decimator.getTimestamps()[i] - centre / SAMPLE_RATE) * SAMPLE_RATE);
+		}
+		decimator.clearOutput();
+	}
+
+	return 10.0 * std::log10(out / in);
+}
+
+/** Gaussian noise of deviation sigma, numFrames rows of numChannels */
+static std::vector<float> makeNoise(int numChannels, int numFrames, float sigma)
+{
+	std::vector<float> noise((size_t)numChannels * numFrames);
+	for (size_t i = 0; i < noise.size(); i++)
+	{
+		double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = (rand() + 1.0) / (RAND_MAX + 2.0);
+		noise[i] = float(sigma * std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * 3.14159265358979323846 * v));
+	}
+	return noise;
+}
+
+int main(int argc, char* argv[])
+{
+	const int numBlocks = argc > 1 ? atoi(argv[1]) : 20000;
+	bool ok = true;
+
+	struct Config
+	{
+		const char* name;
+		RcbFilterSettings settings;
+	};
+
+	Config configs[3];
+	configs[0].name = "HPF 300 (2nd)";
+	configs[0].settings.highPassHz = 300;
+	configs[1].name = "notch 60 x3";
+	configs[1].settings.notchHz = 60;
+	configs[1].settings.notchHarmonics = 3;
+	configs[2].name = "HPF 1 (4th) + notch 50 x5";
+	configs[2].settings.highPassHz = 1;
+	configs[2].settings.highPassOrder = 4;
+	configs[2].settings.notchHz = 50;
+	configs[2].settings.notchHarmonics = 5;
+
+	// response checks
+	RcbFilterSettings both = configs[0].settings;
+	both.notchHz = 60;
+	both.notchHarmonics = 3;
+
+	struct Check
+	{
+		const char* name;
+		double hz;
+		double minDb, maxDb;
+	};
+
+	const Check checks[] = {
+		{ "passband 1 kHz", 1000, -0.5, 0.5 },
+		{ "notch 60 Hz", 60, -1000, -30 },
+		{ "notch 180 Hz", 180, -1000, -30 },
+		{ "high-pass 30 Hz", 30, -1000, -30 },
+	};
+
+	for (const Check& check : checks)
+	{
+		double gain = measureGain(both, check.hz);
+		bool pass = gain >= check.minDb && gain <= check.maxDb;
+		printf("%-18s %8.1f dB %s\n", check.name, gain, pass ? "ok" : "FAIL");
+		ok = ok && pass;
+	}
+
+	// decimation by 30 to 1 kS/s: flat to 300 Hz, 500-700 Hz would alias onto 300-500 Hz
+	{
+		struct DecimationCheck
+		{
+			const char* name;
+			double hz;
+			double minDb, maxDb;
+		};
+
+		const DecimationCheck decimationChecks[] = {
+			{ "LFP 100 Hz", 100, -0.1, 0.1 },
+			{ "LFP 300 Hz", 300, -0.5, 0.1 },
+			{ "LFP alias 530 Hz", 530, -1000, -60 },
+			{ "LFP alias 700 Hz", 700, -1000, -60 },
+		};
+
+		for (const DecimationCheck& check : decimationChecks)
+		{
+			double alignError;
+			double gain = measureDecimation(30, check.hz, alignError);
+			bool pass = gain >= check.minDb && gain <= check.maxDb;
+			printf("%-18s %8.1f dB %s\n", check.name, gain, pass ? "ok" : "FAIL");
+			ok = ok && pass;
+
+			// in the passband each output sample matches the input at its centre sample
+			if (check.maxDb > -1)
+			{
+				pass = alignError < 0.02;
+				printf("%-18s %8.4f    %s\n", "LFP alignment", alignError, pass ? "ok" : "FAIL");
+				ok = ok && pass;
+			}
+		}
+	}
+
+	// every channel carries the same artifact plus its own offset, channel 0 also a large spike
+	for (int mode = 1; mode <= 2; mode++)
+	{
+		const int n = 32;
+		RcbReference reference;
+		reference.setup((RcbReferenceMode)mode, 0, n);
+
+		std::vector<float> row(n);
+		for (int c = 0; c < n; c++)
+			row[c] = 500.0f + float(c) - 15.5f;
+		row[0] += 10000.0f;
+
+		reference.process(row.data(), n, 1);
+
+		// CAR leaves channel 1 off by the spike / n, the median by at most one offset step
+		double error = std::fabs(row[1] - (1.0f - 15.5f));
+		bool pass = mode == 1 ? std::fabs(error - 10000.0 / n) < 0.01 : error <= 1.0;
+		printf("%-18s %8.2f    %s\n", mode == 1 ? "CAR spike leak" : "median spike leak", error, pass ? "ok" : "FAIL");
+		ok = ok && pass;
+	}
+
+	// 10 s of noise of deviation 10 on 32 channels, channel 0 also gets a -120 spike every 100 ms after the estimate settles
+	{
+		const int n = 32, numFrames = int(SAMPLE_RATE) * 10, period = 3000;
+		std::vector<float> signal = makeNoise(n, numFrames, 10.0f);
+		int numInjected = 0;
+
+		for (int f = int(SAMPLE_RATE) * 3; f + 8 < numFrames; f += period, numInjected++)
+		{
+			const float shape[8] = { -40, -120, -90, -40, 10, 30, 20, 10 };
+			for (int s = 0; s < 8; s++)
+				signal[(size_t)(f + s) * n] += shape[s];
+		}
+
+		RcbSpikeSettings settings;
+		settings.enabled = true;
+		RcbSpikeDetector detector;
+		detector.setup(settings, SAMPLE_RATE, n);
+
+		std::vector<unsigned long long> eventWords(numFrames, 0);
+
+		for (int f = 0; f < numFrames; f += 630)
+			detector.process(signal.data() + (size_t)f * n, n, std::min(630, numFrames - f), eventWords.data() + f, 16);
+
+		// the pulse should sit on the -120 sample, or on the -40 before it
+		int numAligned = 0;
+		for (int f = int(SAMPLE_RATE) * 3; f + 8 < numFrames; f += period)
+			numAligned += (((eventWords[f] | eventWords[f + 1]) >> 16) & 1) != 0;
+
+		int numPulses = 0;
+		for (int f = 0; f < numFrames; f++)
+			numPulses += (eventWords[f] >> 16) & 1;
+
+		uint32_t falsePositives = 0;
+		for (int c = 1; c < n; c++)
+			falsePositives += detector.getCount(c);
+
+		bool pass = std::abs((int)detector.getCount(0) - numInjected) <= 2 && numPulses == (int)detector.getCount(0);
+		printf("%-18s %5u/%-3d    %s\n", "spikes found", detector.getCount(0), numInjected, pass ? "ok" : "FAIL");
+		ok = ok && pass;
+
+		pass = numAligned >= numInjected - 1;
+		printf("%-18s %5d/%-3d    %s\n", "spike alignment", numAligned, numInjected, pass ? "ok" : "FAIL");
+		ok = ok && pass;
+
+		// 4.5 deviations of Gaussian noise crosses a few times per channel in 10 s
+		pass = falsePositives <= 5u * (n - 1);
+		printf("%-18s %8u    %s\n", "false positives", falsePositives, pass ? "ok" : "FAIL");
+		ok = ok && pass;
+
+		pass = std::fabs(detector.getThreshold(1) + 45.0f) < 5.0f;
+		printf("%-18s %8.1f    %s\n", "threshold (-45)", detector.getThreshold(1), pass ? "ok" : "FAIL");
+		ok = ok && pass;
+	}
+
+	printf("\n%-28s %8s %8s %14s %12s\n", "stage", "channels", "sections", "ns/sample", "% of a core");
+
+	for (int mode = 1; mode <= 2; mode++)
+	{
+		for (int format = 0; format < RCB_NUM_PACKET_FORMATS; format++)
+		{
+			const int numChannels = RCB_CHANNEL_COUNTS[format];
+			const int numFrames = RCB_SAMPLES_PER_PACKET[format];
+
+			RcbReference reference;
+			reference.setup((RcbReferenceMode)mode, 0, numChannels);
+
+			std::vector<float> block(numFrames * numChannels);
+			for (size_t i = 0; i < block.size(); i++)
+				block[i] = float(rand() % 200 - 100);
+
+			auto start = std::chrono::steady_clock::now();
+			for (int n = 0; n < numBlocks; n++)
+				reference.process(block.data(), numChannels, numFrames);
+			auto end = std::chrono::steady_clock::now();
+
+			double nsPerSample = std::chrono::duration<double, std::nano>(end - start).count() / (double(numBlocks) * numFrames);
+
+			printf("%-28s %8d %8s %14.1f %11.2f%%\n", mode == 1 ? "CAR all" : "median all", numChannels, "-",
+				nsPerSample, nsPerSample * SAMPLE_RATE * 1e-9 * 100.0);
+		}
+	}
+
+	for (int format = 0; format < RCB_NUM_PACKET_FORMATS; format++)
+	{
+		const int numChannels = RCB_CHANNEL_COUNTS[format];
+		const int numFrames = RCB_SAMPLES_PER_PACKET[format];
+
+		RcbSpikeSettings settings;
+		settings.enabled = true;
+		RcbSpikeDetector detector;
+		detector.setup(settings, SAMPLE_RATE, numChannels);
+
+		std::vector<float> block = makeNoise(numChannels, numFrames, 10.0f);
+		std::vector<unsigned long long> eventWords(numFrames, 0);
+
+		auto start = std::chrono::steady_clock::now();
+		for (int n = 0; n < numBlocks; n++)
+			detector.process(block.data(), numChannels, numFrames, eventWords.data(), 16);
+		auto end = std::chrono::steady_clock::now();
+
+		double nsPerSample = std::chrono::duration<double, std::nano>(end - start).count() / (double(numBlocks) * numFrames);
+
+		printf("%-28s %8d %8s %14.1f %11.2f%%\n", "spike detection", numChannels, "-",
+			nsPerSample, nsPerSample * SAMPLE_RATE * 1e-9 * 100.0);
+	}
+
+	for (int format = 0; format < RCB_NUM_PACKET_FORMATS; format++)
+	{
+		const int numChannels = RCB_CHANNEL_COUNTS[format];
+		const int numFrames = RCB_SAMPLES_PER_PACKET[format];
+
+		RcbDecimator decimator;
+		decimator.setup(30, numChannels, numFrames);
+
+		std::vector<float> block = makeNoise(numChannels, numFrames, 10.0f);
+		std::vector<long long> sampleNumbers(numFrames);
+		std::vector<double> timestamps(numFrames, 0);
+
+		auto start = std::chrono::steady_clock::now();
+		for (int n = 0; n < numBlocks; n++)
+		{
+			for (int f = 0; f < numFrames; f++)
+				sampleNumbers[f] = (long long)n * numFrames + f;
+
+			decimator.process(block.data(), numChannels, numFrames, sampleNumbers.data(), timestamps.data(), SAMPLE_RATE);
+			decimator.clearOutput();
+		}
+		auto end = std::chrono::steady_clock::now();
+
+		double nsPerSample = std::chrono::duration<double, std::nano>(end - start).count() / (double(numBlocks) * numFrames);
+
+		printf("%-28s %8d %8d %14.1f %11.2f%%\n", "LFP 1/30", numChannels, decimator.getNumTaps(),
+			nsPerSample, nsPerSample * SAMPLE_RATE * 1e-9 * 100.0);
+	}
+
+	for (const Config& config : configs)
+	{
+		for (int format = 0; format < RCB_NUM_PACKET_FORMATS; format++)
+		{
+			const int numChannels = RCB_CHANNEL_COUNTS[format];
+			const int numFrames = RCB_SAMPLES_PER_PACKET[format];
+
+			RcbFilterBank bank;
+			bank.setup(config.settings, SAMPLE_RATE, numChannels);
+
+			std::vector<float> block(numFrames * numChannels);
+			for (size_t i = 0; i < block.size(); i++)
+				block[i] = float(rand() % 200 - 100);
+
+			auto start = std::chrono::steady_clock::now();
+			for (int n = 0; n < numBlocks; n++)
+				bank.process(block.data(), numChannels, numFrames);
+			auto end = std::chrono::steady_clock::now();
+
+			// a sample here is one row of all channels, as in the sample rate
+			double nsPerSample = std::chrono::duration<double, std::nano>(end - start).count() / (double(numBlocks) * numFrames);
+
+			printf("%-28s %8d %8d %14.1f %11.2f%%\n", config.name, numChannels, bank.getNumSections(),
+				nsPerSample, nsPerSample * SAMPLE_RATE * 1e-9 * 100.0);
+		}
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,471 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+// Headless benchmark of the per-packet path of RcbWifi::updateBuffer(): reorder window, sequence
+// accounting, decode, loss concealment, timestamps and digital inputs, fed with synthetic RCB packets.
+// Runs every channel count with aux on and off over clean, lossy and reordered streams, and prints
+// packets/s, ns/sample and heap allocations as one JSON object on stdout, e.g.
+//   ./RcbPipelineBenchmark --packets 100000 > pipeline-0.1.3.json
+// Returns 1 if the sequence accounting of any run does not match the stream it was fed, or if the
+// streaming loop allocated any memory.
+
+#include "RcbArena.h"
+#include "RcbAuxDemux.h"
+#include "RcbClockRecovery.h"
+#include "RcbConvert.h"
+#include "RcbDecoder.h"
+#include "RcbLogQueue.h"
+#include "RcbSequence.h"
+#include "RcbTtlInput.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifndef RCBWIFI_VERSION
+#define RCBWIFI_VERSION "unknown"
+#endif
+
+using namespace RcbWifiNode;
+
+// every heap allocation in the process, so the timed loop can be checked for allocations
+static std::atomic<uint64_t> numAllocations(0);
+
+void* operator new(size_t size)
+{
+	numAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+/** Synthetic stream shape */
+struct Pattern
+{
+	const char* name;
+	double lossRate;    // chance a lost burst starts at a packet
+	int burst;          // packets lost per burst
+	double swapRate;    // chance a packet arrives after the one following it
+	int window;         // reorder window, packets
+	bool restart;       // the RCB starts its seqNums over at 1 halfway through
+	int shortEvery;     // every shortEvery-th packet arrives truncated to its header, 0 for none
+};
+
+static const Pattern PATTERNS[] = {
+	{ "clean",   0.0,   1, 0.0,  0, false, 0 },
+	{ "loss1",   0.01,  1, 0.0,  0, false, 0 },
+	{ "burst8",  0.002, 8, 0.0,  0, false, 0 },
+	{ "reorder", 0.0,   1, 0.02, 4, false, 0 },
+	{ "mixed",   0.01,  3, 0.02, 4, false, 0 },
+	{ "restart", 0.01,  1, 0.0,  0, true, 0 },
+	{ "restart-mixed", 0.01, 3, 0.02, 4, true, 0 },
+	{ "short",   0.0,   1, 0.0,  0, false, 97 },
+};
+
+// frames in the stand-in for the DataBuffer
+const int OUTPUT_FRAMES = 1 << 14;
+
+// distinct packet payloads cycled through the stream
+const int NUM_TEMPLATES = 64;
+
+static uint64_t rngState = 0x9e3779b97f4a7c15ULL;
+
+static double nextRandom()
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 7;
+	rngState ^= rngState << 17;
+	return double(rngState >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/** Position in the stream where a restarting RCB goes back to seqNum 1 */
+static int restartPosition(const Pattern& pattern, int numPackets)
+{
+	return pattern.restart ? numPackets / 2 + 1 : numPackets + 1;
+}
+
+/** seqNum the RCB sends at stream position 1..numPackets */
+static uint32_t seqNumAt(const Pattern& pattern, int numPackets, uint32_t position)
+{
+	const uint32_t restartAt = (uint32_t)restartPosition(pattern, numPackets);
+	return position >= restartAt ? position - restartAt + 1 : position;
+}
+
+/**
+	Builds the arrival order of stream positions 1..numPackets.  The last packets, and those
+	either side of a restart, are always sent in order, so the reorder window has released
+	everything by the end of the stream and the first packet of a restart is never lost.
+*/
+static std::vector<uint32_t> buildArrivals(const Pattern& pattern, int numPackets, uint32_t& numDropped)
+{
+	const int tail = pattern.window + 2;
+	const int restartAt = restartPosition(pattern, numPackets);
+	std::vector<uint32_t> arrivals;
+	arrivals.reserve(numPackets);
+	numDropped = 0;
+
+	int burstLeft = 0;
+	for (int sn = 1; sn <= numPackets; sn++)
+	{
+		bool inTail = sn > numPackets - tail || std::abs(sn - restartAt) <= tail;
+
+		if (!inTail && sn > 1 && (burstLeft > 0 || nextRandom() < pattern.lossRate))
+		{
+			burstLeft = (burstLeft > 0 ? burstLeft : pattern.burst) - 1;
+			numDropped++;
+			continue;
+		}
+
+		arrivals.push_back((uint32_t)sn);
+	}
+
+	// swap neighbours that are consecutive, so a window of 2 or more puts them back in order
+	for (size_t i = 1; i + tail < arrivals.size(); i++)
+	{
+		if (arrivals[i + 1] == arrivals[i] + 1 && std::abs((int)arrivals[i] - restartAt) > tail && nextRandom() < pattern.swapRate)
+		{
+			std::swap(arrivals[i], arrivals[i + 1]);
+			i++;
+		}
+	}
+
+	return arrivals;
+}
+
+/** Output of the pipeline, the parts of RcbDevice that do not need the GUI */
+struct Pipeline
+{
+	RcbSequenceCounter sequence;
+	RcbReorderWindow reorder;
+	RcbClockRecovery clock;
+	RcbDecoderState decoderState;
+	RcbDecodeFunction decode = decodePacketGeneric;
+
+	int numSamples = 0;
+	int numOutChannels = 0;
+	double packetSeconds = 0;
+	bool started = false;
+
+	RcbArena arena;
+	float* frames = nullptr;
+	long long* sampleNums = nullptr;
+	double* timestamps = nullptr;
+	unsigned long long* ttlWords = nullptr;
+	RcbLogQueue log;
+	int writePos = 0;
+	int64_t totalSamples = 0;
+	RcbTtlInput ttl;
+	RcbAuxDemux aux;
+
+	/** Next free run of numFrames output frames, wraps like the DataBuffer does */
+	int reserve(int numFrames)
+	{
+		if (writePos + numFrames > OUTPUT_FRAMES)
+			writePos = 0;
+
+		int pos = writePos;
+		writePos += numFrames;
+		return pos;
+	}
+
+	uint32_t shortPackets = 0;
+
+	bool processPacket(const uint16_t* packet, int64_t rxTicks)
+	{
+		if ((packet[0] & 0x00ff) != RCB_MAGIC_NUM)
+			return false;
+
+		uint32_t seqNum = ((uint32_t)packet[5] << 16) + packet[4];
+
+		if (!started)
+		{
+			sequence.restart(seqNum);
+			started = true;
+		}
+
+		// the RCB started its seqNums over, as RcbDevice::restartSequence()
+		if (sequence.isRestart(seqNum))
+		{
+			log.push(RcbLogCode::RESTART, seqNum, sequence.nextSeqNum);
+			sequence.restartSequence();
+			clock.resync();
+			aux.reset();
+		}
+
+		int64_t counted = sequence.count(seqNum);
+		if (counted < 0)
+		{
+			log.push(RcbLogCode::DELAYED_PACKET, seqNum);
+			return true;  // dropped, as with concealment on
+		}
+
+		if (counted * numSamples > OUTPUT_FRAMES)
+			log.push(RcbLogCode::GAP_TOO_LONG, (uint64_t)counted);
+
+		// zero fill the lost packets in chunks that fit the output
+		for (int64_t gap = counted * numSamples; gap > 0; )
+		{
+			int chunk = (int)std::min<int64_t>(gap, OUTPUT_FRAMES / 2);
+			int pos = reserve(chunk);
+
+			std::fill(frames + (size_t)pos * numOutChannels, frames + (size_t)(pos + chunk) * numOutChannels, 0.0f);
+			for (int f = 0; f < chunk; f++)
+			{
+				sampleNums[pos + f] = totalSamples + f;
+				ttlWords[pos + f] = ttl.getState();
+			}
+			clock.getTimestamps(totalSamples, chunk, &timestamps[pos]);
+
+			totalSamples += chunk;
+			gap -= chunk;
+		}
+
+		int pos = reserve(numSamples);
+		decode(packet, &frames[(size_t)pos * numOutChannels], decoderState);
+
+		clock.addPacket(totalSamples + numSamples, double(rxTicks) * 1e-9);
+		clock.getTimestamps(totalSamples, numSamples, &timestamps[pos]);
+
+		for (int i = 0; i < numSamples; i++)
+			sampleNums[pos + i] = totalSamples + i;
+		ttl.update(packet[19], totalSamples, numSamples, &ttlWords[pos], 0);
+
+		// the aux rows go to their own stream, dropped here as the DataBuffer push is
+		if (decoderState.auxEnabled)
+		{
+			aux.process(decoderState.auxSlots, numSamples, decoderState.auxFirstPhase, &sampleNums[pos], &timestamps[pos]);
+			aux.clearOutput();
+		}
+
+		totalSamples += numSamples;
+		return true;
+	}
+};
+
+struct Result
+{
+	double seconds = 0;
+	uint64_t allocations = 0;
+	uint32_t numArrived = 0;
+	uint32_t numDropped = 0;
+	uint32_t numShort = 0;      // arrived truncated, rejected as RcbDevice::processPackets()
+	bool ok = true;
+};
+
+static Result runPipeline(int format, bool auxEnabled, const Pattern& pattern, int numPackets)
+{
+	const int numChannels = RCB_CHANNEL_COUNTS[format];
+	const int numSamples = RCB_SAMPLES_PER_PACKET[format];
+	const int frameWords = rcbFrameWords(numChannels);
+	const int packetBytes = rcbPacketBytes(numChannels, numSamples);
+
+	Result result;
+	std::vector<uint32_t> arrivals = buildArrivals(pattern, numPackets, result.numDropped);
+	result.numArrived = (uint32_t)arrivals.size();
+
+	// packet payloads, only the seqNum and receive time change per packet
+	std::vector<RcbPacketSlot> templates(NUM_TEMPLATES);
+	for (int t = 0; t < NUM_TEMPLATES; t++)
+	{
+		RcbPacketSlot& slot = templates[t];
+		std::fill(slot.data, slot.data + RCB_MAX_PACKET_BYTES / 2, 0);
+		slot.length = rcbPacketBytes(numChannels, numSamples);
+		slot.data[0] = RCB_MAGIC_NUM;
+		slot.data[16] = uint16_t(auxEnabled ? 0x0007 | ((t & 3) << 8) : 0);
+		slot.data[18] = 3700;
+		slot.data[19] = uint16_t(t & 1);
+
+		for (int f = 0; f < numSamples; f++)
+			for (int w = 0; w < frameWords; w++)
+				slot.data[RCB_HEADER_WORDS + f * frameWords + w] = uint16_t(32768 + (rand() & 0x0fff) - 0x0800);
+	}
+
+	Pipeline pipeline;
+	pipeline.numSamples = numSamples;
+	pipeline.numOutChannels = numChannels;
+	pipeline.decoderState.numChannels = numChannels;
+	pipeline.decoderState.numSamples = numSamples;
+	pipeline.decoderState.auxEnabled = auxEnabled;
+	pipeline.decode = selectDecoder(numChannels, numSamples, auxEnabled);
+	pipeline.packetSeconds = double(numSamples) / 30000.0;
+	pipeline.clock.reset(30000.0);
+	pipeline.ttl.setup(0);
+	pipeline.aux.setup(RCB_AUX_SCALE, numSamples);
+	pipeline.reorder.setSize(pattern.window);
+	pipeline.reorder.reset();
+	pipeline.sequence.restart();
+
+	// sized once up front, as RcbDevice::resizeBuffers() does
+	const size_t numFrameFloats = (size_t)OUTPUT_FRAMES * pipeline.numOutChannels;
+	if (!pipeline.arena.allocate(RcbArena::bytesFor<float>(numFrameFloats) + RcbArena::bytesFor<long long>(OUTPUT_FRAMES)
+		+ RcbArena::bytesFor<double>(OUTPUT_FRAMES) + RcbArena::bytesFor<unsigned long long>(OUTPUT_FRAMES)))
+	{
+		fprintf(stderr, "could not allocate the output buffers\n");
+		result.ok = false;
+		return result;
+	}
+
+	pipeline.frames = pipeline.arena.take<float>(numFrameFloats);
+	pipeline.sampleNums = pipeline.arena.take<long long>(OUTPUT_FRAMES);
+	pipeline.timestamps = pipeline.arena.take<double>(OUTPUT_FRAMES);
+	pipeline.ttlWords = pipeline.arena.take<unsigned long long>(OUTPUT_FRAMES);
+
+	auto release = [&pipeline](const uint16_t* data, int64_t rxTicks) { return pipeline.processPacket(data, rxTicks); };
+
+	uint64_t allocationsBefore = numAllocations.load();
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < result.numArrived; i++)
+	{
+		const uint32_t position = arrivals[i];
+		const uint32_t sn = seqNumAt(pattern, numPackets, position);
+		RcbPacketSlot& slot = templates[position % NUM_TEMPLATES];
+		slot.data[4] = uint16_t(sn & 0xffff);
+		slot.data[5] = uint16_t(sn >> 16);
+		slot.rxTicks = int64_t((double(position) * pipeline.packetSeconds + 0.001) * 1e9) + int64_t(i % 7) * 20000;
+
+		// truncated packets are never the first or among the last, which the accounting below relies on
+		const bool truncate = pattern.shortEvery > 0 && position % pattern.shortEvery == 0 && (int)position < numPackets - pattern.window - 2;
+		slot.length = truncate ? RCB_HEADER_WORDS * 2 : packetBytes;
+		result.numShort += truncate ? 1 : 0;
+
+		bool good;
+		if (slot.length < packetBytes)
+		{
+			// as RcbDevice::processPackets(), rejected before the sequence is counted
+			pipeline.shortPackets++;
+			good = true;
+		}
+		else if (pattern.window > 0)
+		{
+			if (pipeline.reorder.isTooLate(sn))
+				pipeline.sequence.delayed++;
+
+			good = pipeline.reorder.push(slot, sn, release);
+		}
+		else
+		{
+			good = pipeline.processPacket(slot.data, slot.rxTicks);
+		}
+
+		result.ok = result.ok && good;
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	result.allocations = numAllocations.load() - allocationsBefore;
+	result.seconds = std::chrono::duration<double>(end - start).count();
+
+	// every packet was either decoded or lost, every sample number is accounted for, and nothing was allocated
+	const RcbSequenceCounter& sequence = pipeline.sequence;
+	result.ok = result.ok
+		&& result.allocations == 0
+		&& sequence.hit == result.numArrived - result.numShort
+		&& sequence.miss == result.numDropped + result.numShort
+		&& pipeline.shortPackets == result.numShort
+		&& sequence.delayed == 0
+		&& sequence.restarts == (pattern.restart ? 1u : 0u)
+		&& pipeline.totalSamples == (int64_t)numPackets * numSamples;
+
+	if (result.allocations != 0)
+		fprintf(stderr, "FAIL %d channels, aux %s, %s: %llu heap allocations while streaming, expected none\n",
+			numChannels, auxEnabled ? "on" : "off", pattern.name, (unsigned long long)result.allocations);
+
+	if (!result.ok)
+		fprintf(stderr, "FAIL %d channels, aux %s, %s: hit %u/%u miss %u/%u short %u/%u delayed %u restarts %u samples %lld/%lld allocations %llu\n",
+			numChannels, auxEnabled ? "on" : "off", pattern.name,
+			sequence.hit, result.numArrived - result.numShort, sequence.miss, result.numDropped + result.numShort,
+			pipeline.shortPackets, result.numShort, sequence.delayed, sequence.restarts,
+			(long long)pipeline.totalSamples, (long long)numPackets * numSamples, (unsigned long long)result.allocations);
+
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	int numPackets = 100000;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--packets") == 0 && i + 1 < argc)
+			numPackets = std::max(atoi(argv[++i]), 64);
+		else
+		{
+			fprintf(stderr, "usage: %s [--packets N]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	bool ok = true;
+	char line[512];
+
+	std::string json = "{\"benchmark\":\"pipeline\",\"version\":\"" RCBWIFI_VERSION "\"";
+	snprintf(line, sizeof(line), ",\"simd\":\"%s\",\"packets\":%d,\"results\":[",
+		getSimdLevelName(getBestSimdLevel()), numPackets);
+	json += line;
+
+	bool first = true;
+	for (int format = 0; format < RCB_NUM_PACKET_FORMATS; format++)
+	{
+		for (int aux = 0; aux < 2; aux++)
+		{
+			for (const Pattern& pattern : PATTERNS)
+			{
+				Result result = runPipeline(format, aux == 1, pattern, numPackets);
+				ok = ok && result.ok;
+
+				const int numSamples = RCB_SAMPLES_PER_PACKET[format];
+				double nsPerPacket = result.seconds * 1e9 / result.numArrived;
+
+				// ns per sample counts every sample number written, concealed ones included
+				snprintf(line, sizeof(line),
+					"%s{\"channels\":%d,\"samples\":%d,\"aux\":%s,\"pattern\":\"%s\",\"window\":%d,"
+					"\"received\":%u,\"lost\":%u,\"packetsPerSec\":%.0f,\"nsPerPacket\":%.1f,\"nsPerSample\":%.2f,"
+					"\"allocations\":%llu,\"ok\":%s}",
+					first ? "" : ",", RCB_CHANNEL_COUNTS[format], numSamples, aux ? "true" : "false",
+					pattern.name, pattern.window, result.numArrived, result.numDropped,
+					result.numArrived / result.seconds, nsPerPacket,
+					result.seconds * 1e9 / ((double)numPackets * numSamples),
+					(unsigned long long)result.allocations, result.ok ? "true" : "false");
+				json += line;
+				first = false;
+			}
+		}
+	}
+
+	json += "]}\n";
+	fputs(json.c_str(), stdout);
+
+	if (!ok)
+		fprintf(stderr, "FAIL: see the runs above, the pipeline lost track of the packets or allocated while streaming\n");
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,550 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "RcbPacket.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef SOCKET SocketHandle;
+#define closeSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#define INVALID_SOCKET (-1)
+#define closeSocket close
+#endif
+
+/*
+    Emulates an RCB-W24 module on the local machine: the embedded web server the plugin
+    initializes through, and the 0xc5 UDP data stream.
+
+    RcbEmulator [options]
+      --ip ADDR           address of the emulated RCB web server (127.0.0.1)
+      --http-port N       web server port (80, the plugin always uses 80)
+      --channels N        channels until the plugin sends a channel mask (32)
+      --rate HZ           sample rate until the plugin sends an SPI bit rate (20000)
+      --loss P            probability that a packet is lost (0)
+      --burst N           packets lost in a row for each loss (1)
+      --jitter MS         random extra delay of each packet, packets can overtake (0)
+      --battery V         battery voltage on the status page and in the packets (3.90)
+      --rhd2216           report an RHD2216 headstage instead of an RHD2132
+      --no-keepalive      close the web server connection after each response
+      --stream HOST:PORT  stream right away, without waiting for the plugin
+      --duration S        stop streaming after S seconds, 0 runs until killed (0)
+      --seed N            random seed for loss and jitter (1)
+*/
+
+struct EmulatorSettings
+{
+	std::string ip = "127.0.0.1";
+	int httpPort = 80;
+	int numChannels = 32;
+	double sampleRate = 20000;
+	double loss = 0;
+	int burst = 1;
+	double jitterMs = 0;
+	double battery = 3.90;
+	bool rhd2216 = false;
+	bool keepAlive = true;
+	std::string streamTo = "";
+	double duration = 0;
+	unsigned seed = 1;
+};
+
+/** State set through the __SL_P_ tokens, shared by the web server and the stream threads */
+struct RcbState
+{
+	std::mutex lock;
+	std::string host = "";
+	int hostPort = 0;
+	int numChannels = 32;
+	double sampleRate = 20000;
+	std::atomic<bool> streaming{ false };
+	std::atomic<bool> quit{ false };
+};
+
+static const double TWO_PI = 6.283185307179586;
+
+static EmulatorSettings settings;
+static RcbState rcb;
+
+static bool splitHostPort(const std::string& str, std::string& host, int& port)
+{
+	size_t colon = str.find(':');
+	if (colon == std::string::npos)
+		return false;
+
+	host = str.substr(0, colon);
+	port = atoi(str.c_str() + colon + 1);
+	return port > 0;
+}
+
+/** Same sample rate the RCB gets from this SPI bit rate, see RcbWifi::updateSampleRate() */
+static double sampleRateFromBitrate(int numChannels, double bitrate)
+{
+	int divider = int(std::lround(4e7 / bitrate));
+	int numChannelsEnabled = numChannels + 2;
+	double delay = (divider & 1) ? 187.5e-9 : 200e-9;
+
+	return 1.0 / (numChannelsEnabled * (delay + 16.5 / bitrate));
+}
+
+static void handleToken(const std::string& name, const std::string& value)
+{
+	std::lock_guard<std::mutex> guard(rcb.lock);
+
+	if (name == "UUU")
+	{
+		if (splitHostPort(value, rcb.host, rcb.hostPort))
+			printf("host %s:%d\n", rcb.host.c_str(), rcb.hostPort);
+	}
+	else if (name == "U00")
+	{
+		// channel mask in hex, then the aux sequence
+		unsigned long mask = strtoul(value.c_str(), nullptr, 16);
+		int numChannels = 0;
+		for (; mask != 0; mask >>= 1)
+			numChannels += int(mask & 1);
+
+		if (numChannels > 0)
+			rcb.numChannels = numChannels;
+		printf("channels %d\n", rcb.numChannels);
+	}
+	else if (name == "URB")
+	{
+		double bitrate = atof(value.c_str());
+		if (bitrate > 0)
+			rcb.sampleRate = sampleRateFromBitrate(rcb.numChannels, bitrate);
+		printf("sample rate %.1f Hz\n", rcb.sampleRate);
+	}
+	else if (name == "ULD")
+	{
+		rcb.streaming = value == "ON";
+		printf("stream %s\n", value.c_str());
+	}
+	else
+	{
+		printf("token %s = %s\n", name.c_str(), value.c_str());
+	}
+}
+
+static std::string urlDecode(const std::string& str)
+{
+	std::string out;
+
+	for (size_t i = 0; i < str.size(); i++)
+	{
+		if (str[i] == '+')
+			out += ' ';
+		else if (str[i] == '%' && i + 2 < str.size())
+		{
+			out += char(strtol(str.substr(i + 1, 2).c_str(), nullptr, 16));
+			i += 2;
+		}
+		else
+			out += str[i];
+	}
+
+	return out;
+}
+
+/** Status page laid out the way RcbWifi::getIntanStatusInfo() reads it */
+static std::string statusPage()
+{
+	char battery[32];
+	snprintf(battery, sizeof(battery), "Battery V: %4.2fV", settings.battery);
+
+	// RHD registers 40-44 spell INTAN, then 60 die revision, 61 unipolar/bipolar, 62 number of amplifiers, 63 chip id
+	std::string regs = "RHD Reg:0049004e00540041004e0001000000";
+	regs += settings.rhd2216 ? "10" : "20";
+	regs += settings.rhd2216 ? "0002" : "0001";
+
+	return "<html>\n<body>\nUnknown Token\n<br>\n" + std::string(battery) + "\n<br>\nRCB Emulator\n<br>\n" + regs + "\n</body>\n</html>\n";
+}
+
+static void sendResponse(SocketHandle client, const std::string& status, const std::string& body, bool keepAlive)
+{
+	std::string response = "HTTP/1.1 " + status + "\r\n"
+		"Content-Type: text/html\r\n"
+		"Content-Length: " + std::to_string(body.size()) + "\r\n"
+		"Connection: " + (keepAlive ? "keep-alive" : "close") + "\r\n\r\n" + body;
+
+	send(client, response.data(), int(response.size()), 0);
+}
+
+/** Answers the next request on the connection, pending holds bytes already received.  False when the connection should be closed */
+static bool handleRequest(SocketHandle client, std::string& pending)
+{
+	char buf[2048];
+	size_t headerEnd = std::string::npos;
+	size_t contentLength = 0;
+	bool keepAlive = settings.keepAlive;
+
+	// read the headers, then the body.  pipelined requests can already be in pending
+	while (true)
+	{
+		if (headerEnd == std::string::npos && (headerEnd = pending.find("\r\n\r\n")) != std::string::npos)
+		{
+			std::string headers = pending.substr(0, headerEnd);
+			std::transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+			size_t pos = headers.find("content-length:");
+			if (pos != std::string::npos)
+				contentLength = strtoul(headers.c_str() + pos + 15, nullptr, 10);
+			if (headers.find("connection: close") != std::string::npos)
+				keepAlive = false;
+		}
+
+		if (headerEnd != std::string::npos && pending.size() >= headerEnd + 4 + contentLength)
+			break;
+
+		int n = int(recv(client, buf, sizeof(buf), 0));
+		if (n <= 0)
+			return false;
+		pending.append(buf, n);
+	}
+
+	std::string request = pending.substr(0, headerEnd + 4 + contentLength);
+	pending.erase(0, request.size());
+
+	std::string method = request.substr(0, request.find(' '));
+	std::string path = request.substr(method.size() + 1, request.find(' ', method.size() + 1) - method.size() - 1);
+
+	if (method == "GET")
+	{
+		if (path == "/intan_status.html")
+			sendResponse(client, "200 OK", statusPage(), keepAlive);
+		else
+			sendResponse(client, "404 Not Found", "", keepAlive);
+		return keepAlive;
+	}
+
+	// POST body is __SL_P_XXX=value, possibly several joined by &
+	std::string body = request.substr(headerEnd + 4, contentLength);
+	size_t start = 0;
+
+	while (start < body.size())
+	{
+		size_t end = body.find('&', start);
+		std::string token = urlDecode(body.substr(start, end == std::string::npos ? std::string::npos : end - start));
+		size_t eq = token.find('=');
+
+		if (token.compare(0, 6, "__SL_P") == 0 && eq != std::string::npos)
+			handleToken(token.substr(7, eq - 7), token.substr(eq + 1));
+
+		if (end == std::string::npos)
+			break;
+		start = end + 1;
+	}
+
+	sendResponse(client, "204 No Content", "", keepAlive);
+	return keepAlive;
+}
+
+static void runWebServer()
+{
+	SocketHandle server = socket(AF_INET, SOCK_STREAM, 0);
+	int reuse = 1;
+	setsockopt(server, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(uint16_t(settings.httpPort));
+	inet_pton(AF_INET, settings.ip.c_str(), &addr.sin_addr);
+
+	if (bind(server, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(server, 8) != 0)
+	{
+		printf("could not listen on %s:%d, port 80 may need admin rights\n", settings.ip.c_str(), settings.httpPort);
+		rcb.quit = true;
+		closeSocket(server);
+		return;
+	}
+
+	printf("RCB web server on http://%s:%d\n", settings.ip.c_str(), settings.httpPort);
+
+	while (!rcb.quit)
+	{
+		SocketHandle client = accept(server, nullptr, nullptr);
+		if (client == INVALID_SOCKET)
+			continue;
+
+		// idle connections are closed after a few seconds, as the RCB does
+#ifdef _WIN32
+		DWORD timeout = 5000;
+#else
+		timeval timeout = { 5, 0 };
+#endif
+		setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+
+		std::string pending;
+		while (!rcb.quit && handleRequest(client, pending)) {}
+
+		closeSocket(client);
+	}
+
+	closeSocket(server);
+}
+
+/** Fills one packet the way the RCB firmware lays it out, see RcbPacket.h */
+static void buildPacket(std::vector<uint16_t>& packet, uint32_t seqNum, int numChannels, int numSamples, int64_t firstSample, double sampleRate)
+{
+	packet.assign(rcbPacketBytes(numChannels, numSamples) / 2, 0);
+
+	const int frameWords = rcbFrameWords(numChannels);
+	const uint8_t auxPhase = uint8_t(firstSample & 3);
+
+	packet[0] = RCB_MAGIC_NUM;
+	packet[4] = uint16_t(seqNum & 0xffff);
+	packet[5] = uint16_t(seqNum >> 16);
+	packet[16] = uint16_t(0x0f | (auxPhase << 8));
+	packet[18] = uint16_t((int(settings.battery / (1.467 / 4096 * 40.0 / 9.75)) & 0xfff) << 2);  // see RcbWifi::getBatteryInfo()
+
+	// digital input 1 is a 1 Hz square wave, input 2 toggles every 1000 packets
+	double t = double(firstSample) / sampleRate;
+	packet[19] = uint16_t((std::fmod(t, 1.0) < 0.5 ? 1 : 0) | (((seqNum / 1000) & 1) << 1));
+
+	for (int s = 0; s < numSamples; s++)
+	{
+		uint16_t* frame = &packet[RCB_HEADER_WORDS + s * frameWords];
+		double ts = double(firstSample + s) / sampleRate;
+
+		// aux slot, then the amplifier channels: a sine of 10 Hz times the channel number, 100 uV
+		frame[0] = uint16_t(32768 + 4000 * std::sin(TWO_PI * ts));
+		for (int c = 0; c < numChannels; c++)
+			frame[RCB_FRAME_AUX_WORDS + c] = uint16_t(32768 + 513 * std::sin(TWO_PI * 10 * (c + 1) * ts));
+	}
+}
+
+struct PendingPacket
+{
+	double sendTime;
+	std::vector<uint16_t> data;
+};
+
+static void runStream()
+{
+	SocketHandle sock = socket(AF_INET, SOCK_DGRAM, 0);
+	std::mt19937 rng(settings.seed);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+	std::vector<PendingPacket> pending;
+	uint32_t seqNum = 0;
+	int lossLeft = 0;
+	uint64_t numSent = 0, numLost = 0;
+	double streamStart = 0;
+
+	auto clockStart = std::chrono::steady_clock::now();
+	auto now = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - clockStart).count(); };
+
+	while (!rcb.quit)
+	{
+		if (!rcb.streaming)
+		{
+			if (seqNum != 0)
+				printf("stream stopped after %u packets, %llu sent, %llu lost\n", seqNum, (unsigned long long)numSent, (unsigned long long)numLost);
+
+			seqNum = 0;
+			pending.clear();
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			continue;
+		}
+
+		std::string host;
+		int hostPort, numChannels;
+		double sampleRate;
+		{
+			std::lock_guard<std::mutex> guard(rcb.lock);
+			host = rcb.host;
+			hostPort = rcb.hostPort;
+			numChannels = rcb.numChannels;
+			sampleRate = rcb.sampleRate;
+		}
+
+		int format = 0;
+		while (format < RCB_NUM_PACKET_FORMATS - 1 && RCB_CHANNEL_COUNTS[format] != numChannels)
+			format++;
+		const int numSamples = RCB_SAMPLES_PER_PACKET[format];
+		const double packetPeriod = numSamples / sampleRate;
+
+		if (seqNum == 0)
+		{
+			streamStart = now();
+			numSent = numLost = 0;
+			printf("streaming %d channels at %.1f Hz to %s:%d, %.0f packets/s\n", numChannels, sampleRate, host.c_str(), hostPort, 1.0 / packetPeriod);
+		}
+
+		sockaddr_in dest = {};
+		dest.sin_family = AF_INET;
+		dest.sin_port = htons(uint16_t(hostPort));
+		inet_pton(AF_INET, host.c_str(), &dest.sin_addr);
+
+		// build every packet that is due, sequence numbers start at 1
+		double t = now();
+		while (streamStart + seqNum * packetPeriod <= t)
+		{
+			seqNum++;
+
+			if (lossLeft == 0 && uniform(rng) < settings.loss)
+				lossLeft = settings.burst;
+
+			if (lossLeft > 0)
+			{
+				lossLeft--;
+				numLost++;
+				continue;
+			}
+
+			PendingPacket packet;
+			packet.sendTime = streamStart + seqNum * packetPeriod + uniform(rng) * settings.jitterMs * 0.001;
+			buildPacket(packet.data, seqNum, numChannels, numSamples, int64_t(seqNum - 1) * numSamples, sampleRate);
+			pending.push_back(std::move(packet));
+		}
+
+		// send those whose jittered time has come, in that order
+		std::sort(pending.begin(), pending.end(), [](const PendingPacket& a, const PendingPacket& b) { return a.sendTime < b.sendTime; });
+
+		size_t numDue = 0;
+		while (numDue < pending.size() && pending[numDue].sendTime <= t)
+		{
+			const std::vector<uint16_t>& data = pending[numDue].data;
+			sendto(sock, (const char*)data.data(), int(data.size() * 2), 0, (sockaddr*)&dest, sizeof(dest));
+			numSent++;
+			numDue++;
+		}
+		pending.erase(pending.begin(), pending.begin() + numDue);
+
+		if (settings.duration > 0 && t - streamStart >= settings.duration)
+		{
+			rcb.streaming = false;
+			if (!settings.streamTo.empty())
+				rcb.quit = true;
+		}
+
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+
+	printf("%llu packets sent, %llu lost\n", (unsigned long long)numSent, (unsigned long long)numLost);
+	closeSocket(sock);
+}
+
+static bool parseArgs(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		if (arg == "--rhd2216")
+		{
+			settings.rhd2216 = true;
+			continue;
+		}
+
+		if (arg == "--no-keepalive")
+		{
+			settings.keepAlive = false;
+			continue;
+		}
+
+		if (value == nullptr)
+			return false;
+		i++;
+
+		if (arg == "--ip") settings.ip = value;
+		else if (arg == "--http-port") settings.httpPort = atoi(value);
+		else if (arg == "--channels") settings.numChannels = atoi(value);
+		else if (arg == "--rate") settings.sampleRate = atof(value);
+		else if (arg == "--loss") settings.loss = atof(value);
+		else if (arg == "--burst") settings.burst = std::max(1, atoi(value));
+		else if (arg == "--jitter") settings.jitterMs = atof(value);
+		else if (arg == "--battery") settings.battery = atof(value);
+		else if (arg == "--stream") settings.streamTo = value;
+		else if (arg == "--duration") settings.duration = atof(value);
+		else if (arg == "--seed") settings.seed = unsigned(atoi(value));
+		else return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	if (!parseArgs(argc, argv))
+	{
+		printf("usage: RcbEmulator [--ip ADDR] [--http-port N] [--channels N] [--rate HZ] [--loss P] [--burst N]\n"
+			"                   [--jitter MS] [--battery V] [--rhd2216] [--no-keepalive] [--stream HOST:PORT] [--duration S] [--seed N]\n");
+		return 1;
+	}
+
+#ifdef _WIN32
+	WSADATA wsaData;
+	WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+	setvbuf(stdout, nullptr, _IONBF, 0);  // log lines show up right away when piped
+
+	rcb.numChannels = settings.numChannels;
+	rcb.sampleRate = settings.sampleRate;
+
+	std::thread stream(runStream);
+
+	if (!settings.streamTo.empty())
+	{
+		// traffic generator only, no web server
+		if (!splitHostPort(settings.streamTo, rcb.host, rcb.hostPort))
+		{
+			printf("--stream needs HOST:PORT\n");
+			rcb.quit = true;
+		}
+		rcb.streaming = true;
+	}
+	else
+	{
+		std::thread(runWebServer).detach();
+	}
+
+	stream.join();
+
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	return 0;
+}
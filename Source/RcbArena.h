@@ -0,0 +1,127 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBARENAH__
+#define __RCBARENAH__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// Alignment of the arena and of every block taken from it, one cache line
+const size_t RCB_ARENA_ALIGNMENT = 64;
+
+namespace RcbWifiNode
+{
+    /**
+        One aligned allocation that buffers are carved from, sized once when the stream is set up
+        so nothing is allocated while streaming.  Blocks start on a cache line, so the SIMD
+        conversion kernels get aligned rows and no two buffers share a line.
+    */
+    class RcbArena
+    {
+    public:
+        RcbArena() = default;
+        ~RcbArena() { freeAligned(memory); }
+
+        RcbArena(const RcbArena&) = delete;
+        RcbArena& operator=(const RcbArena&) = delete;
+
+        /** Bytes a block of count T takes in the arena, padding included */
+        template <typename T>
+        static size_t bytesFor(size_t count)
+        {
+            return (count * sizeof(T) + RCB_ARENA_ALIGNMENT - 1) & ~(RCB_ARENA_ALIGNMENT - 1);
+        }
+
+        /**
+            Makes room for numBytes, zeroed, and forgets the blocks taken so far.  Keeps the old
+            allocation when it is big enough.  Returns false if the memory could not be allocated.
+        */
+        bool allocate(size_t numBytes)
+        {
+            used = 0;
+
+            if (numBytes > capacity)
+            {
+                freeAligned(memory);
+                capacity = 0;
+                memory = (uint8_t*)allocateAligned(numBytes);
+
+                if (memory == nullptr)
+                    return false;
+
+                capacity = numBytes;
+            }
+
+            if (memory != nullptr)
+                memset(memory, 0, capacity);
+
+            return true;
+        }
+
+        /** Next block of count T, nullptr if it does not fit what allocate() made room for */
+        template <typename T>
+        T* take(size_t count)
+        {
+            size_t bytes = bytesFor<T>(count);
+
+            if (memory == nullptr || used + bytes > capacity)
+                return nullptr;
+
+            T* block = (T*)(memory + used);
+            used += bytes;
+            return block;
+        }
+
+        size_t getCapacity() const { return capacity; }
+
+    private:
+        static void* allocateAligned(size_t numBytes)
+        {
+#ifdef _MSC_VER
+            return _aligned_malloc(numBytes, RCB_ARENA_ALIGNMENT);
+#else
+            void* p = nullptr;
+            return posix_memalign(&p, RCB_ARENA_ALIGNMENT, numBytes) == 0 ? p : nullptr;
+#endif
+        }
+
+        static void freeAligned(void* p)
+        {
+#ifdef _MSC_VER
+            _aligned_free(p);
+#else
+            free(p);
+#endif
+        }
+
+        uint8_t* memory = nullptr;
+        size_t capacity = 0;
+        size_t used = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "RcbAuxDemux.h"
+
+#include <algorithm>
+
+using namespace RcbWifiNode;
+
+void RcbAuxDemux::setup(float scale_, int maxInputFrames)
+{
+	scale = scale_;
+
+	// a cycle started before the last clearOutput() can complete in the next block, one more row for that
+	const int maxOutput = maxInputFrames / RCB_AUX_PHASES + 2;
+	outData.resize((size_t)maxOutput * RCB_NUM_AUX_CHANNELS);
+	outSampleNumbers.resize(maxOutput);
+	outTimestamps.resize(maxOutput);
+	outEventWords.assign(maxOutput, 0);
+
+	reset();
+}
+
+void RcbAuxDemux::reset()
+{
+	std::fill(values, values + RCB_NUM_AUX_CHANNELS, 0.0f);
+	seenMask = 0;
+	middleTimestamp = 0;
+	numOutput = 0;
+}
+
+void RcbAuxDemux::process(const uint16_t* slots, int numFrames, int firstPhase, const long long* sampleNumbers, const double* timestamps)
+{
+	const int maxOutput = (int)outSampleNumbers.size();
+
+	for (int i = 0; i < numFrames; i++)
+	{
+		const int phase = (firstPhase + i) & (RCB_AUX_PHASES - 1);
+
+		if (phase == 0)
+			continue;
+
+		// same conversion as the aux channels of the amplifier stream had
+		values[phase - 1] = scale * (float)(uint16_t)(slots[i] - 32768);
+		seenMask |= 1 << (phase - 1);
+
+		if (phase == 2)
+			middleTimestamp = timestamps[i];
+
+		if (phase != RCB_AUX_PHASES - 1 || seenMask != (1 << RCB_NUM_AUX_CHANNELS) - 1)
+			continue;
+
+		// only when the aux phase jumps between packets more often than the sizing allows
+		if (numOutput == maxOutput)
+		{
+			numDropped++;
+			continue;
+		}
+
+		std::copy(values, values + RCB_NUM_AUX_CHANNELS, outData.data() + (size_t)numOutput * RCB_NUM_AUX_CHANNELS);
+		outSampleNumbers[numOutput] = sampleNumbers[i] / RCB_AUX_PHASES;
+		outTimestamps[numOutput] = middleTimestamp;
+		numOutput++;
+	}
+}
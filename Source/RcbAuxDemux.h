@@ -0,0 +1,92 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBAUXDEMUXH__
+#define __RCBAUXDEMUXH__
+
+#include <cstdint>
+#include <vector>
+
+// RHD aux inputs published, carried by aux phases 1 to 3
+const int RCB_NUM_AUX_CHANNELS = 3;
+
+// Aux sample scale, the channel bitVolts of the aux stream
+const float RCB_AUX_SCALE = 0.0000374f;
+
+// Frames per aux cycle, one aux slot each, so the aux rate is the sample rate / RCB_AUX_PHASES
+const int RCB_AUX_PHASES = 4;
+
+namespace RcbWifiNode
+{
+    /**
+        Demultiplexes the aux slots of the frames into the RHD aux inputs, one output row per aux cycle.
+
+        Each frame carries one aux slot, for the phase it is at in a 4 frame cycle; phases 1 to 3
+        are the aux inputs.  A row is output when a phase 3 slot completes a cycle, so the rows are
+        4 samples apart: its sample number is that of the phase 3 frame / 4, which steps by one per
+        cycle, and its timestamp is that of the phase 2 frame, the middle of the three inputs.
+    */
+    class RcbAuxDemux
+    {
+    public:
+        /** Allocates, only call when not streaming */
+        void setup(float scale, int maxInputFrames);
+
+        /** Forgets the aux values, no rows until each input has been seen again */
+        void reset();
+
+        /**
+            Takes the aux slots of numFrames frames, the first at aux phase firstPhase.
+            sampleNumbers and timestamps are those of the frames, the pointer type is that of JUCE int64.
+        */
+        void process(const uint16_t* slots, int numFrames, int firstPhase, const long long* sampleNumbers, const double* timestamps);
+
+        /** Output block since the last clearOutput(), RCB_NUM_AUX_CHANNELS floats per row, no TTL words set */
+        float* getData() { return outData.data(); }
+        long long* getSampleNumbers() { return outSampleNumbers.data(); }
+        double* getTimestamps() { return outTimestamps.data(); }
+        unsigned long long* getEventWords() { return outEventWords.data(); }
+        int getNumOutput() const { return numOutput; }
+        void clearOutput() { numOutput = 0; }
+
+        /** Rows dropped on a full output block since clearNumDropped(), reset() keeps the count */
+        uint32_t getNumDropped() const { return numDropped; }
+        void clearNumDropped() { numDropped = 0; }
+
+    private:
+        float scale = 0;
+        float values[RCB_NUM_AUX_CHANNELS];
+        int seenMask = 0;           // inputs seen since reset, bit per input
+        double middleTimestamp = 0;
+
+        std::vector<float> outData;
+        std::vector<long long> outSampleNumbers;
+        std::vector<double> outTimestamps;
+        std::vector<unsigned long long> outEventWords;
+        int numOutput = 0;
+        uint32_t numDropped = 0;
+    };
+}
+
+#endif
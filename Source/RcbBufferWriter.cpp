@@ -0,0 +1,141 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "RcbBufferWriter.h"
+
+using namespace RcbWifiNode;
+
+RcbBufferWriter::RcbBufferWriter()
+{
+}
+
+RcbBufferWriter::~RcbBufferWriter()
+{
+}
+
+bool RcbBufferWriter::setBuffer(DataBuffer* dataBuffer, int numChans, int numSamples)
+{
+	buffer = dataBuffer;
+	numChannels = numChans;
+	capacity = numSamples;
+	numPending = 0;
+
+	size_t numBytes = RcbArena::bytesFor<float>(capacity * numChannels)
+		+ RcbArena::bytesFor<int64>(capacity)
+		+ RcbArena::bytesFor<double>(capacity)
+		+ RcbArena::bytesFor<uint64>(capacity)
+		+ RcbArena::bytesFor<float>(numChannels);
+
+	if (!arena.allocate(numBytes))
+	{
+		capacity = 0;
+		data = nullptr;
+		return false;
+	}
+
+	data = arena.take<float>(capacity * numChannels);
+	sampleNumbers = arena.take<int64>(capacity);
+	timestamps = arena.take<double>(capacity);
+	eventWords = arena.take<uint64>(capacity);
+	lastFrame = arena.take<float>(numChannels);
+
+	return true;
+}
+
+void RcbBufferWriter::reset()
+{
+	numPending = 0;
+
+	if (lastFrame != nullptr)
+		std::fill(lastFrame, lastFrame + numChannels, 0.0f);
+}
+
+float* RcbBufferWriter::reserve(int numSamples)
+{
+	jassert(numSamples <= capacity);
+
+	if (numPending + numSamples > capacity)
+		flush();
+
+	return data + numPending * numChannels;
+}
+
+void RcbBufferWriter::flush()
+{
+	if (numPending == 0)
+		return;
+
+	const float* last = data + (numPending - 1) * numChannels;
+	std::copy(last, last + numChannels, lastFrame);
+
+	if (auxDemux != nullptr && auxBuffer != nullptr && auxDemux->getNumOutput() > 0)
+	{
+		auxBuffer->addToBuffer(auxDemux->getData(),
+			auxDemux->getSampleNumbers(),
+			auxDemux->getTimestamps(),
+			auxDemux->getEventWords(),
+			auxDemux->getNumOutput(),
+			1);
+
+		auxDemux->clearOutput();
+	}
+
+	if (decimator != nullptr && decimator->isActive() && decimatedBuffer != nullptr)
+	{
+		decimator->process(data, numChannels, numPending, sampleNumbers, timestamps, sampleRate);
+
+		if (decimator->getNumOutput() > 0)
+			decimatedBuffer->addToBuffer(decimator->getData(),
+				decimator->getSampleNumbers(),
+				decimator->getTimestamps(),
+				decimator->getEventWords(),
+				decimator->getNumOutput(),
+				1);
+
+		decimator->clearOutput();
+	}
+
+	// in place, so filtering costs no extra copy
+	if (filter != nullptr && filter->isActive())
+		filter->process(data, numChannels, numPending);
+
+	// detect on what goes to the DataBuffer, so the thresholds match the filtered traces
+	if (spikeDetector != nullptr && spikeDetector->isActive())
+		spikeDetector->process(data, numChannels, numPending, eventWords, spikeFirstLine);
+
+	buffer->addToBuffer(data,
+		sampleNumbers,
+		timestamps,
+		eventWords,
+		numPending,
+		1);
+
+	numPending = 0;
+}
+
+void RcbBufferWriter::getLastFrame(float* frame) const
+{
+	const float* last = numPending > 0 ? data + (numPending - 1) * numChannels : lastFrame;
+	std::copy(last, last + numChannels, frame);
+}
@@ -0,0 +1,131 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBBUFFERWRITERH__
+#define __RCBBUFFERWRITERH__
+
+#include <DataThreadHeaders.h>
+
+#include "RcbArena.h"
+#include "RcbAuxDemux.h"
+#include "RcbDecimator.h"
+#include "RcbFilterBank.h"
+#include "RcbSpikeDetector.h"
+
+namespace RcbWifiNode
+{
+    /**
+        Reserve/commit writer in front of one DataBuffer.
+
+        The decoder and the loss concealment write samples into the staging block returned by
+        reserve(), then commit() it.  Committed samples are copied to the DataBuffer by one
+        addToBuffer() when flush() is called or the staging block is full.  The plugin API keeps
+        the DataBuffer ring private, so that copy stays, as it was before the writer; what the
+        writer saves is the per-packet allocations and Array::set calls, the staging block is
+        sized once in setBuffer().
+    */
+    class RcbBufferWriter
+    {
+    public:
+        /** Constructor */
+        RcbBufferWriter();
+
+        /** Destructor */
+        ~RcbBufferWriter();
+
+        /**
+            Sets the DataBuffer and the staging size, in samples of numChannels floats. Drops pending samples.
+            Returns false if the staging block could not be allocated.
+        */
+        bool setBuffer(DataBuffer* buffer, int numChannels, int capacity);
+
+        /** Filters run over each block on its way to the DataBuffer, nullptr for none */
+        void setFilter(RcbFilterBank* filter_) { filter = filter_; }
+
+        /** Decimation into a second DataBuffer, fed before the filters so the low band is kept. nullptr for none */
+        void setDecimator(RcbDecimator* decimator_, DataBuffer* decimatedBuffer_, double sampleRate_)
+        {
+            decimator = decimator_;
+            decimatedBuffer = decimatedBuffer_;
+            sampleRate = sampleRate_;
+        }
+
+        /** Aux rows pushed to their own DataBuffer along with each block, nullptr for none */
+        void setAuxDemux(RcbAuxDemux* auxDemux_, DataBuffer* auxBuffer_) { auxDemux = auxDemux_; auxBuffer = auxBuffer_; }
+
+        /** Spike detection run on each block after the filters, its events go on TTL lines from firstLine. nullptr for none */
+        void setSpikeDetector(RcbSpikeDetector* detector, int firstLine) { spikeDetector = detector; spikeFirstLine = firstLine; }
+
+        /** Drops pending samples and forgets the last frame */
+        void reset();
+
+        /**
+            Returns room for numSamples samples of getNumChannels() floats each, sample-major.
+            Flushes first if they do not fit.  numSamples must not exceed getCapacity().
+        */
+        float* reserve(int numSamples);
+
+        /** Sample numbers, timestamps and TTL words of the block returned by the last reserve() */
+        int64* getSampleNumbers() { return sampleNumbers + numPending; }
+        double* getTimestamps() { return timestamps + numPending; }
+        uint64* getEventWords() { return eventWords + numPending; }
+
+        /** Adds numSamples reserved samples to the pending block */
+        void commit(int numSamples) { numPending += numSamples; }
+
+        /** Pushes the pending samples to the DataBuffer */
+        void flush();
+
+        /** Copies the last committed sample, as it was before filtering, into frame */
+        void getLastFrame(float* frame) const;
+
+        int getNumChannels() const { return numChannels; }
+        int getCapacity() const { return capacity; }
+
+    private:
+        DataBuffer* buffer = nullptr;
+        RcbFilterBank* filter = nullptr;
+        RcbSpikeDetector* spikeDetector = nullptr;
+        RcbAuxDemux* auxDemux = nullptr;
+        DataBuffer* auxBuffer = nullptr;
+        RcbDecimator* decimator = nullptr;
+        DataBuffer* decimatedBuffer = nullptr;
+        double sampleRate = 0;
+        int spikeFirstLine = 0;
+        int numChannels = 0;
+        int capacity = 0;
+        int numPending = 0;
+
+        /** Staging block, sized in setBuffer() */
+        RcbArena arena;
+        float* data = nullptr;
+        int64* sampleNumbers = nullptr;
+        double* timestamps = nullptr;
+        uint64* eventWords = nullptr;
+        float* lastFrame = nullptr;   // last sample flushed
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RcbBufferWriter);
+    };
+}
+#endif
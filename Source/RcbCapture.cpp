@@ -0,0 +1,270 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+#include "RcbCapture.h"
+
+using namespace RcbWifiNode;
+
+static const char RCB_CAPTURE_MAGIC[8] = "RCBCAP1";
+
+static File getSegmentSibling(const File& firstFile, int index)
+{
+	// name_000.rcbcap -> name_001.rcbcap
+	String name = firstFile.getFileNameWithoutExtension().dropLastCharacters(3) + String(index).paddedLeft('0', 3);
+	return firstFile.getSiblingFile(name + firstFile.getFileExtension());
+}
+
+RcbCaptureWriter::RcbCaptureWriter() : Thread("RCB Capture")
+{
+	memset(&header, 0, sizeof(header));
+}
+
+RcbCaptureWriter::~RcbCaptureWriter()
+{
+	close();
+}
+
+File RcbCaptureWriter::getSegmentFile(int index) const
+{
+	return getSegmentSibling(File(basePath + "_000.rcbcap"), index);
+}
+
+bool RcbCaptureWriter::open(const String& basePath_, int64 segmentBytes_, const Array<RcbCaptureDevice>& devices)
+{
+	close();
+
+	basePath = basePath_;
+	segmentBytes = jmax(segmentBytes_, int64(1024 * 1024));
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, RCB_CAPTURE_MAGIC, sizeof(header.magic));
+	header.headerBytes = sizeof(RcbCaptureHeader);
+	header.ticksPerSecond = Time::getHighResolutionTicksPerSecond();
+	header.startTicks = Time::getHighResolutionTicks();
+	header.startTimeMs = Time::currentTimeMillis();
+	header.numDevices = (uint32_t)jmin(devices.size(), RCB_CAPTURE_MAX_DEVICES);
+
+	for (uint32_t d = 0; d < header.numDevices; d++)
+		header.devices[d] = devices[d];
+
+	numPackets = 0;
+	numDropped = 0;
+	numBytes = 0;
+	numSegments = 0;
+	nextIndex = 0;
+
+	// only a cheap check here, on the message thread; sizing and pre-faulting the first segment
+	// takes a while, so the background thread prepares it and write() switches to it when ready
+	File folder = getFirstFile().getParentDirectory();
+
+	if (!folder.isDirectory() || !folder.hasWriteAccess())
+	{
+		LOGC("[dspw] Cannot write capture files to ", folder.getFullPathName());
+		return false;
+	}
+
+	startThread();
+	segmentNeeded.signal();
+
+	return true;
+}
+
+void RcbCaptureWriter::close()
+{
+	stopThread(5000);
+
+	finishSegment(full.exchange(nullptr));
+	finishSegment(current);
+	current = nullptr;
+
+	// prepared but never written, leave no empty file behind
+	if (Segment* unused = next.exchange(nullptr))
+	{
+		unused->map.reset();
+		unused->file.deleteFile();
+		numSegments--;
+		delete unused;
+	}
+}
+
+bool RcbCaptureWriter::nextSegment()
+{
+	// the background thread has not caught up, drop rather than block the reader thread
+	if (next.load() == nullptr || full.load() != nullptr)
+		return false;
+
+	full.store(current);
+	current = next.exchange(nullptr);
+	segmentNeeded.signal();
+
+	return current != nullptr;
+}
+
+RcbCaptureWriter::Segment* RcbCaptureWriter::createSegment(int index)
+{
+	auto segment = std::make_unique<Segment>();
+	segment->file = getSegmentFile(index);
+	segment->file.deleteFile();
+
+	{
+		// size the file up front, its pages are allocated below
+		FileOutputStream out(segment->file);
+
+		if (!out.openedOk() || !out.setPosition(segmentBytes - 1) || !out.writeByte(0))
+		{
+			LOGC("[dspw] Could not create capture file ", segment->file.getFullPathName());
+			return nullptr;
+		}
+	}
+
+	segment->map = std::make_unique<MemoryMappedFile>(segment->file, MemoryMappedFile::readWrite);
+	segment->data = (uint8_t*)segment->map->getData();
+	segment->size = (int64)segment->map->getSize();
+
+	if (segment->data == nullptr || segment->size < segmentBytes)
+	{
+		LOGC("[dspw] Could not map capture file ", segment->file.getFullPathName());
+		return nullptr;
+	}
+
+	// touch every page now, so the reader thread does not take the page faults
+	for (int64 p = 0; p < segment->size; p += 4096)
+		((volatile uint8_t*)segment->data)[p] = 0;
+
+	header.segmentIndex = (uint32_t)index;
+	memcpy(segment->data, &header, sizeof(header));
+	segment->used = sizeof(header);
+
+	numSegments++;
+
+	return segment.release();
+}
+
+void RcbCaptureWriter::finishSegment(Segment* segment)
+{
+	if (segment == nullptr)
+		return;
+
+	const int64 used = segment->used;
+
+	// the length 0 record ends the segment, then cut the file after it
+	memset(segment->data + used, 0, sizeof(RcbCaptureRecord));
+	segment->map.reset();
+
+	FileOutputStream out(segment->file);
+	if (out.openedOk() && out.setPosition(used + (int64)sizeof(RcbCaptureRecord)))
+		out.truncate();
+
+	delete segment;
+}
+
+void RcbCaptureWriter::run()
+{
+	while (!threadShouldExit())
+	{
+		segmentNeeded.wait(500);
+
+		finishSegment(full.exchange(nullptr));
+
+		if (next.load() == nullptr && !threadShouldExit())
+		{
+			Segment* segment = createSegment(nextIndex++);
+			next.store(segment);
+
+			if (segment != nullptr)
+				LOGD("[dspw] RCB capture segment ", segment->file.getFullPathName(), " ready");
+		}
+	}
+}
+
+bool RcbCaptureReader::open(const File& firstFile_)
+{
+	firstFile = firstFile_;
+	segmentIndex = 0;
+
+	if (!openSegment(0))
+		return false;
+
+	memcpy(&header, data, sizeof(header));
+
+	return true;
+}
+
+bool RcbCaptureReader::openSegment(int index)
+{
+	File file = index == 0 ? firstFile : getSegmentSibling(firstFile, index);
+
+	map.reset();
+	data = nullptr;
+
+	if (!file.existsAsFile())
+		return false;
+
+	map = std::make_unique<MemoryMappedFile>(file, MemoryMappedFile::readOnly);
+	data = (const uint8_t*)map->getData();
+	size = (int64)map->getSize();
+
+	RcbCaptureHeader segmentHeader;
+
+	if (data == nullptr || size < (int64)sizeof(segmentHeader))
+		return false;
+
+	memcpy(&segmentHeader, data, sizeof(segmentHeader));
+
+	if (memcmp(segmentHeader.magic, RCB_CAPTURE_MAGIC, sizeof(segmentHeader.magic)) != 0)
+	{
+		LOGC("[dspw] Not an RCB capture file ", file.getFullPathName());
+		return false;
+	}
+
+	pos = segmentHeader.headerBytes;
+	segmentIndex = index;
+
+	return true;
+}
+
+bool RcbCaptureReader::next(RcbCaptureRecord& record, const uint8_t*& recordData)
+{
+	while (data != nullptr)
+	{
+		if (pos + (int64)sizeof(record) <= size)
+		{
+			memcpy(&record, data + pos, sizeof(record));
+
+			if (record.length > 0 && pos + (int64)sizeof(record) + record.length <= size)
+			{
+				recordData = data + pos + sizeof(record);
+				pos += sizeof(record) + ((int64(record.length) + 7) & ~int64(7));
+				return true;
+			}
+		}
+
+		// end of this segment, go on with the next one
+		if (!openSegment(segmentIndex + 1))
+			break;
+	}
+
+	return false;
+}
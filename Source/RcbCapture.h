@@ -0,0 +1,207 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+#ifndef __RCBCAPTUREH__
+#define __RCBCAPTUREH__
+
+#include <DataThreadHeaders.h>
+
+#include "RcbPacketRing.h"
+
+// Capture segment size unless set with the CAPTURE config message
+const int64 RCB_CAPTURE_SEGMENT_BYTES = 256 * 1024 * 1024;
+
+// Largest segment the CAPTURE config message accepts, MB. Each one is mapped whole
+const int RCB_CAPTURE_MAX_SEGMENT_MB = 4096;
+
+// Devices described in each segment header
+const int RCB_CAPTURE_MAX_DEVICES = 16;
+
+namespace RcbWifiNode
+{
+    /**
+        Capture files hold every datagram the plugin received, in receive order, split into
+        segments name_000.rcbcap, name_001.rcbcap and so on.  Each segment is an
+        RcbCaptureHeader followed by records: an RcbCaptureRecord and the datagram bytes,
+        padded to 8 bytes.  A record with length 0, or the end of the file, ends the segment.
+    */
+    struct RcbCaptureDevice
+    {
+        char ipNumStr[16];
+        uint16_t port;
+        uint16_t numChannels;
+        uint16_t numSamples;
+        uint16_t auxEnabled;
+        float sampleRate;
+    };
+
+    struct RcbCaptureHeader
+    {
+        char magic[8];              // "RCBCAP1"
+        uint32_t headerBytes;       // sizeof(RcbCaptureHeader), records start here
+        uint32_t segmentIndex;
+        int64_t ticksPerSecond;     // of the record rxTicks
+        int64_t startTicks;         // rxTicks clock at startTimeMs
+        int64_t startTimeMs;        // wall clock, ms since 1970
+        uint32_t numDevices;
+        uint32_t reserved;
+        RcbCaptureDevice devices[RCB_CAPTURE_MAX_DEVICES];
+    };
+
+    struct RcbCaptureRecord
+    {
+        uint32_t length;            // datagram bytes that follow
+        uint16_t port;              // UDP port it arrived on, identifies the device
+        uint16_t reserved;
+        int64_t rxTicks;            // host receive time, Time::getHighResolutionTicks()
+    };
+
+    /**
+        Journals received datagrams into preallocated, memory mapped capture segments.
+
+        write() is called from the socket reader thread and only copies into mapped memory.
+        A background thread creates, sizes and pre-faults each segment, the first one included,
+        ahead of time and trims each full one, so neither the reader thread nor the caller of
+        open() waits on the file system.  If a segment is not ready in time, packets are counted
+        as dropped from the capture.
+    */
+    class RcbCaptureWriter : private Thread
+    {
+    public:
+        /** Constructor */
+        RcbCaptureWriter();
+
+        /** Closes the capture */
+        ~RcbCaptureWriter();
+
+        /** Starts preparing basePath_000.rcbcap in the background. False if the folder cannot be written */
+        bool open(const String& basePath, int64 segmentBytes, const Array<RcbCaptureDevice>& devices);
+
+        /** Trims the last segment to its records and stops the background thread. Call after the reader thread stopped */
+        void close();
+
+        /** Appends one datagram. Socket reader thread only */
+        void write(uint16_t port, const RcbPacketSlot& slot)
+        {
+            const int64 recordBytes = sizeof(RcbCaptureRecord) + ((int64(slot.length) + 7) & ~int64(7));
+
+            // keep room for the length 0 record that ends the segment
+            if (current == nullptr || current->used + recordBytes + int64(sizeof(RcbCaptureRecord)) > current->size)
+            {
+                if (!nextSegment())
+                {
+                    numDropped++;
+                    return;
+                }
+            }
+
+            uint8_t* dst = current->data + current->used;
+            RcbCaptureRecord record = { uint32_t(slot.length), port, 0, slot.rxTicks };
+
+            memcpy(dst, &record, sizeof(record));
+            memcpy(dst + sizeof(record), slot.data, size_t(slot.length));
+
+            current->used += recordBytes;
+            numPackets++;
+            numBytes += recordBytes;
+        }
+
+        /** First segment file, e.g. to pass to replay */
+        File getFirstFile() const { return getSegmentFile(0); }
+
+        int64 getNumPackets() const { return numPackets; }
+        int64 getNumDropped() const { return numDropped; }
+        int64 getNumBytes() const { return numBytes; }
+        int getNumSegments() const { return numSegments; }
+
+    private:
+        struct Segment
+        {
+            File file;
+            std::unique_ptr<MemoryMappedFile> map;
+            uint8_t* data = nullptr;
+            int64 size = 0;
+            int64 used = 0;
+        };
+
+        /** Hands the full segment to the background thread and switches to the prepared one */
+        bool nextSegment();
+
+        /** Creates, sizes, maps and pre-faults one segment and writes its header */
+        Segment* createSegment(int index);
+
+        /** Unmaps a segment and trims the file to its records */
+        void finishSegment(Segment* segment);
+
+        File getSegmentFile(int index) const;
+
+        /** Background thread, keeps the next segment ready */
+        void run() override;
+
+        String basePath;
+        int64 segmentBytes = RCB_CAPTURE_SEGMENT_BYTES;
+        RcbCaptureHeader header;
+
+        Segment* current = nullptr;                     // reader thread
+        std::atomic<Segment*> next{ nullptr };          // made by run(), taken by the reader thread
+        std::atomic<Segment*> full{ nullptr };          // given by the reader thread, finished by run()
+        std::atomic<int> nextIndex{ 0 };
+        WaitableEvent segmentNeeded;
+
+        std::atomic<int64> numPackets{ 0 };
+        std::atomic<int64> numDropped{ 0 };
+        std::atomic<int64> numBytes{ 0 };
+        std::atomic<int> numSegments{ 0 };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RcbCaptureWriter);
+    };
+
+    /** Reads the records of a capture back in order, across its segments */
+    class RcbCaptureReader
+    {
+    public:
+        /** Opens a capture from its first segment, basePath_000.rcbcap */
+        bool open(const File& firstFile);
+
+        /** Next record.  data stays valid until the next call.  False at the end of the capture */
+        bool next(RcbCaptureRecord& record, const uint8_t*& data);
+
+        /** Header of the first segment */
+        const RcbCaptureHeader& getHeader() const { return header; }
+
+    private:
+        bool openSegment(int index);
+
+        File firstFile;
+        RcbCaptureHeader header;
+        std::unique_ptr<MemoryMappedFile> map;
+        const uint8_t* data = nullptr;
+        int64 size = 0;
+        int64 pos = 0;
+        int segmentIndex = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "RcbClockRecovery.h"
+
+#include <cmath>
+
+using namespace RcbWifiNode;
+
+// weight of old packets, about 4096 packets or a few seconds of fit
+static const double FORGET = 1.0 - 1.0 / 4096.0;
+
+// weight of old residuals in the jitter estimate
+static const double JITTER_FORGET = 1.0 - 1.0 / 256.0;
+
+// packets later than this many times the jitter, plus a floor, are outliers
+static const double LATE_LIMIT = 4.0;
+static const double LIMIT_FLOOR = 0.0002;
+
+void RcbClockRecovery::reset(double rate)
+{
+	sampleRate = rate > 0 ? rate : 30000;
+	resync();
+
+	numRejected = 0;
+	numResyncs = 0;
+}
+
+void RcbClockRecovery::resync()
+{
+	sampleRef = 0;
+	hostRef = 0;
+	intercept = 0;
+	slope = 1.0;
+	sw = sx = sy = sxx = sxy = 0;
+
+	jitter = 0;
+	numPoints = 0;
+	numSinceAnchor = 0;
+	numRejectedInRow = 0;
+	numResyncs++;
+}
+
+bool RcbClockRecovery::addPacket(int64_t endSampleNumber, double rxSeconds)
+{
+	if (numPoints == 0)
+	{
+		sampleRef = endSampleNumber;
+		hostRef = rxSeconds;
+	}
+
+	double x = double(endSampleNumber - sampleRef) / sampleRate;
+	double y = rxSeconds - hostRef;
+	double residual = y - (intercept + slope * x);
+
+	if (isLocked() && residual > LATE_LIMIT * jitter + LIMIT_FLOOR)
+	{
+		numRejected++;
+
+		if (++numRejectedInRow < RESYNC_PACKETS)
+			return false;
+
+		// every packet is late, the old fit no longer holds
+		resync();
+		return addPacket(endSampleNumber, rxSeconds);
+	}
+
+	numRejectedInRow = 0;
+	jitter = numPoints == 0 ? 0 : JITTER_FORGET * jitter + (1.0 - JITTER_FORGET) * std::fabs(residual);
+
+	sw = FORGET * sw + 1.0;
+	sx = FORGET * sx + x;
+	sy = FORGET * sy + y;
+	sxx = FORGET * sxx + x * x;
+	sxy = FORGET * sxy + x * y;
+	numPoints++;
+
+	double det = sw * sxx - sx * sx;
+
+	// until the packets span some time only the offset is fitted
+	if (numPoints < 2 || det <= 1e-12 * sw * sw)
+	{
+		slope = 1.0;
+		intercept = (sy - sx) / sw;
+	}
+	else
+	{
+		slope = (sw * sxy - sx * sy) / det;
+		intercept = (sy - slope * sx) / sw;
+	}
+
+	// otherwise x and y grow for the whole session and the fit loses precision over hours
+	if (++numSinceAnchor >= REANCHOR_PACKETS)
+		reanchor(endSampleNumber);
+
+	return true;
+}
+
+void RcbClockRecovery::reanchor(int64_t sampleNumber)
+{
+	const double dx = double(sampleNumber - sampleRef) / sampleRate;
+	const double dy = intercept + slope * dx;
+
+	sxx = sxx - 2.0 * dx * sx + dx * dx * sw;
+	sxy = sxy - dx * sy - dy * sx + dx * dy * sw;
+	sx -= dx * sw;
+	sy -= dy * sw;
+
+	sampleRef = sampleNumber;
+	hostRef += dy;
+	intercept = 0;
+	numSinceAnchor = 0;
+}
+
+void RcbClockRecovery::getTimestamps(int64_t firstSample, int numSamples, double* dst) const
+{
+	double t = getTimestamp(firstSample);
+	double step = slope / sampleRate;
+
+	for (int i = 0; i < numSamples; i++)
+		dst[i] = t + step * i;
+}
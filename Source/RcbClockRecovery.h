@@ -0,0 +1,106 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBCLOCKRECOVERYH__
+#define __RCBCLOCKRECOVERYH__
+
+#include <cstdint>
+
+namespace RcbWifiNode
+{
+    /**
+        Recovers the RCB sample clock against the host clock.
+
+        Each packet gives one point: the sample number just after its last sample, and the host
+        time it was received.  A linear fit with exponential forgetting maps sample numbers to host
+        time, so the slope follows the drift between the two crystals.  WiFi delays only ever make
+        packets late, so packets far later than the fit are left out of it.  The intercept includes
+        the shortest network delay, which cannot be separated without extra hardware.
+    */
+    class RcbClockRecovery
+    {
+    public:
+        /** Starts a new fit and clears the counters, at the start of acquisition */
+        void reset(double sampleRate);
+
+        /** Starts a new fit after the clocks jumped, e.g. the RCB restarted.  Keeps the counters, counts a resync */
+        void resync();
+
+        /**
+            Adds one packet.  endSampleNumber is the sample number after its last sample, rxSeconds
+            the host receive time.  Returns false if the packet was rejected as a jitter outlier.
+        */
+        bool addPacket(int64_t endSampleNumber, double rxSeconds);
+
+        /** Host time of one sample, in seconds */
+        double getTimestamp(int64_t sampleNumber) const
+        {
+            return hostRef + intercept + slope * double(sampleNumber - sampleRef) / sampleRate;
+        }
+
+        /** Host times of numSamples consecutive samples starting at firstSample */
+        void getTimestamps(int64_t firstSample, int numSamples, double* dst) const;
+
+        /** Sample clock error against the host clock, parts per million */
+        double getDriftPpm() const { return (slope - 1.0) * 1e6; }
+
+        /** Mean distance of accepted packets from the fit, seconds */
+        double getJitter() const { return jitter; }
+
+        uint32_t getNumRejected() const { return numRejected; }
+        uint32_t getNumResyncs() const { return numResyncs; }
+        bool isLocked() const { return numPoints >= LOCK_PACKETS; }
+
+    private:
+        // packets before the outlier test starts
+        static const int LOCK_PACKETS = 64;
+
+        // rejected packets in a row that mean the clocks jumped, e.g. the RCB restarted
+        static const int RESYNC_PACKETS = 500;
+
+        double sampleRate = 30000;
+
+        // fit in seconds relative to a recent packet, moved every REANCHOR_PACKETS to keep the sums small
+        static const int REANCHOR_PACKETS = 4096;
+        int64_t sampleRef = 0;
+        double hostRef = 0;
+        double intercept = 0;
+        double slope = 1.0;
+
+        // exponentially weighted sums of the fit
+        double sw = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+
+        double jitter = 0;
+        int numPoints = 0;
+        int numSinceAnchor = 0;
+        int numRejectedInRow = 0;
+        uint32_t numRejected = 0;
+        uint32_t numResyncs = 0;
+
+        /** Moves sampleRef to sampleNumber and hostRef to its time on the current fit, shifting the sums to match */
+        void reanchor(int64_t sampleNumber);
+    };
+}
+
+#endif
@@ -0,0 +1,214 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "RcbControlClient.h"
+
+using namespace RcbWifiNode;
+
+// requests sent back to back before waiting for their responses
+#define RCB_MAX_PIPELINED_REQUESTS 16
+
+// longest the destructor waits for the queued requests to go out
+#define RCB_CONTROL_SHUTDOWN_WAIT_MS 1000
+
+RcbControlClient::RcbControlClient(int numWorkers) :
+	alive(std::make_shared<std::atomic<bool>>(true)),
+	pool(numWorkers)
+{
+	idle.signal();
+}
+
+RcbControlClient::~RcbControlClient()
+{
+	// let queued requests go out, RCBs must not be left streaming
+	if (!idle.wait(RCB_CONTROL_SHUTDOWN_WAIT_MS))
+		LOGD("[dspw] RCB control requests still running at shutdown");
+
+	alive->store(false);
+	pool.removeAllJobs(true, 1000);
+}
+
+std::future<RcbResponse> RcbControlClient::post(const String& ipNumStr, const String& postData, RcbResponseCallback callback, int timeoutMs)
+{
+	auto request = std::make_unique<Request>();
+	request->ipNumStr = ipNumStr;
+	request->postData = postData;
+	request->isPost = true;
+	request->timeoutMs = timeoutMs;
+	request->callback = callback;
+
+	return queue(std::move(request));
+}
+
+std::future<RcbResponse> RcbControlClient::get(const String& ipNumStr, const String& path, RcbResponseCallback callback)
+{
+	auto request = std::make_unique<Request>();
+	request->ipNumStr = ipNumStr;
+	request->path = path;
+	request->callback = callback;
+
+	return queue(std::move(request));
+}
+
+RcbControlStats RcbControlClient::getStats(const String& ipNumStr)
+{
+	const ScopedLock sl(queueLock);
+
+	auto device = deviceQueues.find(ipNumStr);
+	return device != deviceQueues.end() ? device->second.stats : RcbControlStats();
+}
+
+bool RcbControlClient::isBusy()
+{
+	const ScopedLock sl(queueLock);
+
+	for (auto& device : deviceQueues)
+	{
+		if (device.second.running || !device.second.requests.empty())
+			return true;
+	}
+
+	return false;
+}
+
+std::future<RcbResponse> RcbControlClient::queue(std::unique_ptr<Request> request)
+{
+	std::future<RcbResponse> result = request->promise.get_future();
+	String ipNumStr = request->ipNumStr;
+	bool startJob = false;
+
+	{
+		const ScopedLock sl(queueLock);
+		DeviceQueue& device = deviceQueues[ipNumStr];
+		device.requests.push_back(std::move(request));
+		idle.reset();
+
+		// one job per RCB keeps its requests in order
+		if (!device.running)
+		{
+			device.running = true;
+			startJob = true;
+		}
+	}
+
+	if (startJob)
+		pool.addJob([this, ipNumStr] { runDevice(ipNumStr); });
+
+	return result;
+}
+
+void RcbControlClient::runDevice(const String& ipNumStr)
+{
+	RcbHttpConnection* connection;
+
+	{
+		const ScopedLock sl(queueLock);
+		DeviceQueue& device = deviceQueues[ipNumStr];
+
+		if (device.connection == nullptr)
+			device.connection = std::make_unique<RcbHttpConnection>(ipNumStr);
+
+		connection = device.connection.get();
+	}
+
+	std::vector<std::unique_ptr<Request>> batch;
+	std::vector<const RcbHttpRequest*> httpRequests;
+	std::vector<RcbResponse> responses;
+
+	while (true)
+	{
+		batch.clear();
+		httpRequests.clear();
+
+		{
+			const ScopedLock sl(queueLock);
+			DeviceQueue& device = deviceQueues[ipNumStr];
+
+			if (device.requests.empty())
+			{
+				device.running = false;
+
+				bool allIdle = true;
+				for (auto& other : deviceQueues)
+					allIdle = allIdle && !other.second.running && other.second.requests.empty();
+
+				if (allIdle)
+					idle.signal();
+
+				return;
+			}
+
+			// everything queued so far goes out pipelined
+			while (!device.requests.empty() && (int)batch.size() < RCB_MAX_PIPELINED_REQUESTS)
+			{
+				batch.push_back(std::move(device.requests.front()));
+				device.requests.pop_front();
+				httpRequests.push_back(batch.back().get());
+			}
+		}
+
+		connection->exchange(httpRequests, responses);
+
+		{
+			const ScopedLock sl(queueLock);
+			RcbControlStats& stats = deviceQueues[ipNumStr].stats;
+
+			for (auto& response : responses)
+			{
+				stats.numRequests++;
+
+				if (!response.ok && response.statusCode == 0)
+				{
+					stats.numFailed++;
+					continue;
+				}
+
+				stats.lastRoundTripMs = response.roundTripMs;
+				stats.maxRoundTripMs = jmax(stats.maxRoundTripMs, response.roundTripMs);
+				stats.meanRoundTripMs += (response.roundTripMs - stats.meanRoundTripMs) / (stats.numRequests - stats.numFailed);
+			}
+
+			stats.numConnects = connection->getNumConnects();
+			stats.pipelining = connection->isPipelining();
+		}
+
+		for (size_t i = 0; i < batch.size(); i++)
+		{
+			const RcbResponse& response = responses[i];
+
+			if (batch[i]->callback != nullptr)
+			{
+				auto isAlive = alive;
+				auto callback = batch[i]->callback;
+				MessageManager::callAsync([isAlive, callback, response]
+				{
+					if (isAlive->load())
+						callback(response);
+				});
+			}
+
+			batch[i]->promise.set_value(response);
+		}
+	}
+}
@@ -0,0 +1,121 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBCONTROLCLIENTH__
+#define __RCBCONTROLCLIENTH__
+
+#include <DataThreadHeaders.h>
+
+#include "RcbHttpConnection.h"
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+
+namespace RcbWifiNode
+{
+    /** Counters of the requests to one RCB */
+    struct RcbControlStats
+    {
+        int numRequests = 0;
+        int numFailed = 0;
+        int numConnects = 0;        // connections opened, 1 if the RCB kept it alive throughout
+        bool pipelining = true;
+        double lastRoundTripMs = 0;
+        double meanRoundTripMs = 0;
+        double maxRoundTripMs = 0;
+    };
+
+    typedef std::function<void(const RcbResponse&)> RcbResponseCallback;
+
+    /**
+        Sends the HTTP requests that control the RCBs from a pool of worker threads.
+
+        Requests to one RCB go out in the order they were queued, over one kept-alive
+        connection, with the requests queued meanwhile pipelined behind each other; requests
+        to different RCBs run in parallel.  Nothing here blocks the caller: each request returns a
+        future, and its callback, if any, is called on the message thread.
+    */
+    class RcbControlClient
+    {
+    public:
+        /** Constructor */
+        RcbControlClient(int numWorkers = 8);
+
+        /** Waits up to a second for the queued requests, e.g. the stream OFF at shutdown, then drops callbacks */
+        ~RcbControlClient();
+
+        /** Queues a POST of postData, e.g. "__SL_P_ULD=ON", to the RCB at ipNumStr.  timeoutMs 0 is the default timeout */
+        std::future<RcbResponse> post(const String& ipNumStr, const String& postData, RcbResponseCallback callback = nullptr, int timeoutMs = 0);
+
+        /** Queues a GET of path, e.g. "/intan_status.html", from the RCB at ipNumStr */
+        std::future<RcbResponse> get(const String& ipNumStr, const String& path, RcbResponseCallback callback = nullptr);
+
+        /** True while any request is queued or running */
+        bool isBusy();
+
+        /** Request counters and round trip times of the RCB at ipNumStr */
+        RcbControlStats getStats(const String& ipNumStr);
+
+    private:
+        struct Request : RcbHttpRequest
+        {
+            String ipNumStr;
+            RcbResponseCallback callback;
+            std::promise<RcbResponse> promise;
+        };
+
+        /** Requests to one RCB, drained by at most one pool job at a time */
+        struct DeviceQueue
+        {
+            std::deque<std::unique_ptr<Request>> requests;
+            bool running = false;
+
+            /** Only used by the job that drains the queue */
+            std::unique_ptr<RcbHttpConnection> connection;
+            RcbControlStats stats;
+        };
+
+        std::future<RcbResponse> queue(std::unique_ptr<Request> request);
+
+        /** Pool job: runs the requests of one RCB until its queue is empty */
+        void runDevice(const String& ipNumStr);
+
+        CriticalSection queueLock;
+        std::map<String, DeviceQueue> deviceQueues;
+
+        /** Cleared when the client is destroyed, so late callbacks are not called */
+        std::shared_ptr<std::atomic<bool>> alive;
+
+        /** Signalled while no request is queued or running */
+        WaitableEvent idle { true };
+
+        ThreadPool pool;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RcbControlClient);
+    };
+}
+
+#endif
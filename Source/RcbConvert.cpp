@@ -0,0 +1,322 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "RcbConvert.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RCB_HAVE_SSE2 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define RCB_TARGET_AVX2
+#else
+#define RCB_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#define RCB_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define RCB_FORCE_INLINE __forceinline
+#else
+#define RCB_FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+using namespace RcbWifiNode;
+
+// The kernels are inlined into the fixed channel count versions below, which unroll the channel loop
+RCB_FORCE_INLINE static void convertScalar(const uint16_t* src, int srcStride, float* dst, int dstStride,
+	int numFrames, int numChannels, float scale, uint16_t offset)
+{
+	for (int f = 0; f < numFrames; f++)
+	{
+		const uint16_t* s = src + f * srcStride;
+		float* d = dst + f * dstStride;
+
+		for (int c = 0; c < numChannels; c++)
+			d[c] = scale * (float)((int)s[c] - (int)offset);
+	}
+}
+
+#ifdef RCB_HAVE_SSE2
+RCB_FORCE_INLINE static void convertSSE2(const uint16_t* src, int srcStride, float* dst, int dstStride,
+	int numFrames, int numChannels, float scale, uint16_t offset)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i off = _mm_set1_epi32(offset);
+	const __m128 sc = _mm_set1_ps(scale);
+
+	for (int f = 0; f < numFrames; f++)
+	{
+		const uint16_t* s = src + f * srcStride;
+		float* d = dst + f * dstStride;
+		int c = 0;
+
+		for (; c + 8 <= numChannels; c += 8)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(s + c));
+			__m128i lo = _mm_sub_epi32(_mm_unpacklo_epi16(v, zero), off);
+			__m128i hi = _mm_sub_epi32(_mm_unpackhi_epi16(v, zero), off);
+			_mm_storeu_ps(d + c, _mm_mul_ps(_mm_cvtepi32_ps(lo), sc));
+			_mm_storeu_ps(d + c + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), sc));
+		}
+
+		// channel counts are multiples of 4
+		for (; c + 4 <= numChannels; c += 4)
+		{
+			__m128i v = _mm_loadl_epi64((const __m128i*)(s + c));
+			__m128i lo = _mm_sub_epi32(_mm_unpacklo_epi16(v, zero), off);
+			_mm_storeu_ps(d + c, _mm_mul_ps(_mm_cvtepi32_ps(lo), sc));
+		}
+
+		for (; c < numChannels; c++)
+			d[c] = scale * (float)((int)s[c] - (int)offset);
+	}
+}
+
+RCB_TARGET_AVX2 RCB_FORCE_INLINE static void convertAVX2(const uint16_t* src, int srcStride, float* dst, int dstStride,
+	int numFrames, int numChannels, float scale, uint16_t offset)
+{
+	const __m256i off = _mm256_set1_epi32(offset);
+	const __m256 sc = _mm256_set1_ps(scale);
+
+	for (int f = 0; f < numFrames; f++)
+	{
+		const uint16_t* s = src + f * srcStride;
+		float* d = dst + f * dstStride;
+		int c = 0;
+
+		for (; c + 16 <= numChannels; c += 16)
+		{
+			__m256i lo = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(s + c)));
+			__m256i hi = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(s + c + 8)));
+			_mm256_storeu_ps(d + c, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(lo, off)), sc));
+			_mm256_storeu_ps(d + c + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(hi, off)), sc));
+		}
+
+		for (; c + 8 <= numChannels; c += 8)
+		{
+			__m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(s + c)));
+			_mm256_storeu_ps(d + c, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(v, off)), sc));
+		}
+
+		for (; c + 4 <= numChannels; c += 4)
+		{
+			__m128i v = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)(s + c)));
+			v = _mm_sub_epi32(v, _mm256_castsi256_si128(off));
+			_mm_storeu_ps(d + c, _mm_mul_ps(_mm_cvtepi32_ps(v), _mm256_castps256_ps128(sc)));
+		}
+
+		for (; c < numChannels; c++)
+			d[c] = scale * (float)((int)s[c] - (int)offset);
+	}
+}
+
+static bool cpuHasAVX2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#ifdef RCB_HAVE_NEON
+RCB_FORCE_INLINE static void convertNEON(const uint16_t* src, int srcStride, float* dst, int dstStride,
+	int numFrames, int numChannels, float scale, uint16_t offset)
+{
+	const int32x4_t off = vdupq_n_s32(offset);
+
+	for (int f = 0; f < numFrames; f++)
+	{
+		const uint16_t* s = src + f * srcStride;
+		float* d = dst + f * dstStride;
+		int c = 0;
+
+		for (; c + 8 <= numChannels; c += 8)
+		{
+			uint16x8_t v = vld1q_u16(s + c);
+			int32x4_t lo = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(v))), off);
+			int32x4_t hi = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(v))), off);
+			vst1q_f32(d + c, vmulq_n_f32(vcvtq_f32_s32(lo), scale));
+			vst1q_f32(d + c + 4, vmulq_n_f32(vcvtq_f32_s32(hi), scale));
+		}
+
+		for (; c + 4 <= numChannels; c += 4)
+		{
+			int32x4_t lo = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vld1_u16(s + c))), off);
+			vst1q_f32(d + c, vmulq_n_f32(vcvtq_f32_s32(lo), scale));
+		}
+
+		for (; c < numChannels; c++)
+			d[c] = scale * (float)((int)s[c] - (int)offset);
+	}
+}
+#endif
+
+template <int NumChannels>
+static void convertScalarFixed(const uint16_t* src, int srcStride, float* dst, int dstStride,
+	int numFrames, int, float scale, uint16_t offset)
+{
+	convertScalar(src, srcStride, dst, dstStride, numFrames, NumChannels, scale, offset);
+}
+
+#ifdef RCB_HAVE_SSE2
+template <int NumChannels>
+static void convertSSE2Fixed(const uint16_t* src, int srcStride, float* dst, int dstStride,
+	int numFrames, int, float scale, uint16_t offset)
+{
+	convertSSE2(src, srcStride, dst, dstStride, numFrames, NumChannels, scale, offset);
+}
+
+template <int NumChannels>
+RCB_TARGET_AVX2 static void convertAVX2Fixed(const uint16_t* src, int srcStride, float* dst, int dstStride,
+	int numFrames, int, float scale, uint16_t offset)
+{
+	convertAVX2(src, srcStride, dst, dstStride, numFrames, NumChannels, scale, offset);
+}
+#endif
+
+#ifdef RCB_HAVE_NEON
+template <int NumChannels>
+static void convertNEONFixed(const uint16_t* src, int srcStride, float* dst, int dstStride,
+	int numFrames, int, float scale, uint16_t offset)
+{
+	convertNEON(src, srcStride, dst, dstStride, numFrames, NumChannels, scale, offset);
+}
+#endif
+
+// one entry per channel count 4, 8, ... RCB_MAX_FIXED_CHANNELS
+#define RCB_FIXED_KERNELS(kernel) \
+	{ kernel<4>, kernel<8>, kernel<12>, kernel<16>, kernel<20>, kernel<24>, kernel<28>, kernel<32> }
+
+RcbSimdLevel RcbWifiNode::getBestSimdLevel()
+{
+	static const RcbSimdLevel best = []
+	{
+#ifdef RCB_HAVE_SSE2
+		return cpuHasAVX2() ? RcbSimdLevel::AVX2 : RcbSimdLevel::SSE2;
+#elif defined(RCB_HAVE_NEON)
+		return RcbSimdLevel::NEON;
+#else
+		return RcbSimdLevel::SCALAR;
+#endif
+	}();
+
+	return best;
+}
+
+RcbConvertFunction RcbWifiNode::getConvertFunction(RcbSimdLevel level)
+{
+	switch (level)
+	{
+	case RcbSimdLevel::SCALAR:
+		return convertScalar;
+#ifdef RCB_HAVE_SSE2
+	case RcbSimdLevel::SSE2:
+		return convertSSE2;
+	case RcbSimdLevel::AVX2:
+		return cpuHasAVX2() ? convertAVX2 : nullptr;
+#endif
+#ifdef RCB_HAVE_NEON
+	case RcbSimdLevel::NEON:
+		return convertNEON;
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+RcbConvertFunction RcbWifiNode::getFixedConvertFunction(RcbSimdLevel level, int numChannels)
+{
+	if (numChannels < 4 || numChannels > RCB_MAX_FIXED_CHANNELS || numChannels % 4 != 0)
+		return nullptr;
+
+	const int index = numChannels / 4 - 1;
+
+	switch (level)
+	{
+	case RcbSimdLevel::SCALAR:
+	{
+		static const RcbConvertFunction kernels[] = RCB_FIXED_KERNELS(convertScalarFixed);
+		return kernels[index];
+	}
+#ifdef RCB_HAVE_SSE2
+	case RcbSimdLevel::SSE2:
+	{
+		static const RcbConvertFunction kernels[] = RCB_FIXED_KERNELS(convertSSE2Fixed);
+		return kernels[index];
+	}
+	case RcbSimdLevel::AVX2:
+	{
+		static const RcbConvertFunction kernels[] = RCB_FIXED_KERNELS(convertAVX2Fixed);
+		return cpuHasAVX2() ? kernels[index] : nullptr;
+	}
+#endif
+#ifdef RCB_HAVE_NEON
+	case RcbSimdLevel::NEON:
+	{
+		static const RcbConvertFunction kernels[] = RCB_FIXED_KERNELS(convertNEONFixed);
+		return kernels[index];
+	}
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+const char* RcbWifiNode::getSimdLevelName(RcbSimdLevel level)
+{
+	switch (level)
+	{
+	case RcbSimdLevel::SSE2: return "SSE2";
+	case RcbSimdLevel::AVX2: return "AVX2";
+	case RcbSimdLevel::NEON: return "NEON";
+	default: return "Scalar";
+	}
+}
+
+void RcbWifiNode::convertSamples(const uint16_t* src, int srcStride, float* dst, int dstStride,
+	int numFrames, int numChannels, float scale, uint16_t offset)
+{
+	static const RcbConvertFunction convert = getConvertFunction(getBestSimdLevel());
+
+	convert(src, srcStride, dst, dstStride, numFrames, numChannels, scale, offset);
+}
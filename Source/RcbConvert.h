@@ -0,0 +1,79 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBCONVERTH__
+#define __RCBCONVERTH__
+
+#include <cstdint>
+
+namespace RcbWifiNode
+{
+    /** Instruction sets the sample conversion kernel is built for */
+    enum class RcbSimdLevel
+    {
+        SCALAR = 0,
+        SSE2,
+        AVX2,
+        NEON
+    };
+
+    /**
+        Converts numFrames frames of numChannels unsigned samples to floats:
+        dst[f * dstStride + c] = scale * (src[f * srcStride + c] - offset)
+
+        srcStride and dstStride are in elements, so the aux slots of an RCB frame
+        can be skipped on the way in and left free on the way out.
+    */
+    typedef void (*RcbConvertFunction)(const uint16_t* src, int srcStride,
+        float* dst, int dstStride,
+        int numFrames, int numChannels,
+        float scale, uint16_t offset);
+
+    /** Fastest kernel supported by this CPU, chosen once at first use */
+    RcbSimdLevel getBestSimdLevel();
+
+    /** Returns the kernel for a given level, or nullptr if it is not available on this CPU */
+    RcbConvertFunction getConvertFunction(RcbSimdLevel level);
+
+    /** Largest channel count with a fixed channel count kernel */
+    const int RCB_MAX_FIXED_CHANNELS = 32;
+
+    /**
+        Returns the kernel for a given level with the channel count fixed at compile time, so its
+        channel loop is unrolled; numChannels is ignored when it is called.  nullptr if the level is
+        not available or there is no kernel for numChannels (multiples of 4 up to RCB_MAX_FIXED_CHANNELS).
+    */
+    RcbConvertFunction getFixedConvertFunction(RcbSimdLevel level, int numChannels);
+
+    /** Name used in logs and benchmark output */
+    const char* getSimdLevelName(RcbSimdLevel level);
+
+    /** Runs the best available kernel */
+    void convertSamples(const uint16_t* src, int srcStride,
+        float* dst, int dstStride,
+        int numFrames, int numChannels,
+        float scale, uint16_t offset);
+}
+
+#endif
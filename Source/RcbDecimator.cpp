@@ -0,0 +1,125 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "RcbDecimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace RcbWifiNode;
+
+static const double PI = 3.14159265358979323846;
+
+void RcbDecimator::setup(int factor_, int numChans, int maxInputFrames)
+{
+	factor = std::min(std::max(factor_, 0), RCB_DECIMATOR_MAX_FACTOR);
+	numChannels = std::min(std::max(numChans, 0), RCB_FILTER_MAX_CHANNELS);
+
+	if (factor < 2)
+	{
+		taps.clear();
+		delay = 0;
+		reset();
+		return;
+	}
+
+	const int numTaps = factor * RCB_DECIMATOR_TAPS_PER_OUTPUT + 1;
+	const double cutoff = 0.38 / factor;     // -6 dB point, in input samples
+	delay = (numTaps - 1) / 2;
+	taps.resize(numTaps);
+
+	double sum = 0;
+	for (int k = 0; k < numTaps; k++)
+	{
+		const int t = k - delay;
+		const double sinc = t == 0 ? 2.0 * cutoff : std::sin(2.0 * PI * cutoff * t) / (PI * t);
+		const double window = 0.42 - 0.5 * std::cos(2.0 * PI * k / (numTaps - 1)) + 0.08 * std::cos(4.0 * PI * k / (numTaps - 1));
+		taps[k] = float(sinc * window);
+		sum += taps[k];
+	}
+
+	// unity gain at DC
+	for (float& tap : taps)
+		tap = float(tap / sum);
+
+	history.assign((size_t)2 * numTaps * numChannels, 0.0f);
+
+	const int maxOutput = maxInputFrames / factor + 1;
+	outData.resize((size_t)maxOutput * numChannels);
+	outSampleNumbers.resize(maxOutput);
+	outTimestamps.resize(maxOutput);
+	outEventWords.assign(maxOutput, 0);
+
+	reset();
+}
+
+void RcbDecimator::reset()
+{
+	std::fill(history.begin(), history.end(), 0.0f);
+	position = 0;
+	numOutput = 0;
+}
+
+void RcbDecimator::process(const float* frames, int stride, int numFrames, const long long* sampleNumbers, const double* timestamps, double sampleRate)
+{
+	if (!isActive())
+		return;
+
+	const int n = numChannels;
+	const int numTaps = (int)taps.size();
+	const int maxOutput = (int)outSampleNumbers.size();
+
+	for (int f = 0; f < numFrames; f++)
+	{
+		const float* x = frames + (size_t)f * stride;
+		std::copy(x, x + n, history.data() + (size_t)position * n);
+		std::copy(x, x + n, history.data() + (size_t)(position + numTaps) * n);
+
+		// oldest row of the window ending at this row
+		const float* window = history.data() + (size_t)(position + 1) * n;
+		position = position + 1 == numTaps ? 0 : position + 1;
+
+		// the output centred on input sample s = sampleNumber - delay, kept when s is a multiple of factor
+		const long long centre = sampleNumbers[f] - delay;
+		if (centre < 0 || centre % factor != 0 || numOutput == maxOutput)
+			continue;
+
+		float* y = outData.data() + (size_t)numOutput * n;
+		std::fill(y, y + n, 0.0f);
+
+		// the taps are symmetric, so the window can be walked oldest first
+		for (int k = 0; k < numTaps; k++)
+		{
+			const float h = taps[k];
+			const float* row = window + (size_t)k * n;
+
+			for (int c = 0; c < n; c++)
+				y[c] += h * row[c];
+		}
+
+		outSampleNumbers[numOutput] = centre / factor;
+		outTimestamps[numOutput] = timestamps[f] - delay / sampleRate;
+		numOutput++;
+	}
+}
@@ -0,0 +1,98 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBDECIMATORH__
+#define __RCBDECIMATORH__
+
+#include <vector>
+
+#include "RcbFilterBank.h"
+
+// Largest decimation factor
+const int RCB_DECIMATOR_MAX_FACTOR = 64;
+
+// FIR taps per output sample, the filter has factor x this + 1 taps
+const int RCB_DECIMATOR_TAPS_PER_OUTPUT = 32;
+
+namespace RcbWifiNode
+{
+    /**
+        Anti-aliased decimation of the amplifier channels by an integer factor, for an LFP stream.
+
+        A linear phase, Blackman windowed sinc low-pass with its -6 dB point at 0.38 of the output
+        rate, computed only for the samples that are kept.  It is flat to 0.3 and down 70 dB from
+        0.47 of the output rate.  Output sample n is centred on input sample n x factor, so the
+        two streams stay locked over gaps and restarts: its sample number is the input sample
+        number / factor and its timestamp that of the input sample, the filter delay taken out.
+    */
+    class RcbDecimator
+    {
+    public:
+        /** factor 0 or 1 turns it off.  Allocates, only call when not streaming */
+        void setup(int factor, int numChannels, int maxInputFrames);
+
+        /** Clears the filter history and any output */
+        void reset();
+
+        bool isActive() const { return factor > 1 && numChannels > 0; }
+        int getFactor() const { return factor; }
+        int getNumTaps() const { return (int)taps.size(); }
+
+        /** Filter delay, input samples */
+        int getDelay() const { return delay; }
+
+        /**
+            Decimates the first numChannels floats of numFrames rows, rows are stride floats apart.
+            Output rows are appended to the output block.  sampleNumbers and timestamps are those of
+            the input rows, the pointer types are those of JUCE int64.
+        */
+        void process(const float* frames, int stride, int numFrames, const long long* sampleNumbers, const double* timestamps, double sampleRate);
+
+        /** Output block since the last clearOutput(), numChannels floats per row, no TTL words set */
+        float* getData() { return outData.data(); }
+        long long* getSampleNumbers() { return outSampleNumbers.data(); }
+        double* getTimestamps() { return outTimestamps.data(); }
+        unsigned long long* getEventWords() { return outEventWords.data(); }
+        int getNumOutput() const { return numOutput; }
+        void clearOutput() { numOutput = 0; }
+
+    private:
+        int factor = 0;
+        int numChannels = 0;
+        int delay = 0;
+        std::vector<float> taps;
+
+        // last getNumTaps() rows twice over, so the window ending at any row is contiguous
+        std::vector<float> history;
+        int position = 0;
+
+        std::vector<float> outData;
+        std::vector<long long> outSampleNumbers;
+        std::vector<double> outTimestamps;
+        std::vector<unsigned long long> outEventWords;
+        int numOutput = 0;
+    };
+}
+
+#endif
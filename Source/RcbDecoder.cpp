@@ -0,0 +1,105 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "RcbDecoder.h"
+#include "RcbConvert.h"
+
+using namespace RcbWifiNode;
+
+void RcbWifiNode::decodePacketGeneric(const uint16_t* packet, float* dst, RcbDecoderState& state)
+{
+	const int numChannels = state.numChannels;
+	const int frameWords = rcbFrameWords(numChannels);
+
+	convertSamples(packet + RCB_HEADER_WORDS + RCB_FRAME_AUX_WORDS, frameWords,
+		dst, numChannels,
+		state.numSamples, numChannels,
+		state.scale, state.offset);
+
+	if (state.auxEnabled)
+	{
+		state.auxFirstPhase = packet[16] >> 8;
+
+		// in RCB packet aux samples are located before electrode samples.
+		for (int i = 0; i < state.numSamples && i < RCB_MAX_SAMPLES_PER_PACKET; i++)
+			state.auxSlots[i] = packet[RCB_HEADER_WORDS + i * frameWords];
+	}
+}
+
+/**
+    Decoder with the packet geometry known at compile time.  The samples go through the best
+    conversion kernel built for this channel count, and the aux test is resolved at compile time.
+*/
+template <int NumChannels, int NumSamples, bool AuxEnabled>
+static void decodePacketSpecialized(const uint16_t* packet, float* dst, RcbDecoderState& state)
+{
+	constexpr int frameWords = NumChannels + RCB_FRAME_AUX_WORDS;
+	static_assert(NumSamples <= RCB_MAX_SAMPLES_PER_PACKET, "aux slots do not fit the decoder state");
+
+	static const RcbConvertFunction convert = getFixedConvertFunction(getBestSimdLevel(), NumChannels);
+
+	const uint16_t* frame = packet + RCB_HEADER_WORDS;
+
+	convert(frame + RCB_FRAME_AUX_WORDS, frameWords, dst, NumChannels,
+		NumSamples, NumChannels, state.scale, state.offset);
+
+	if constexpr (AuxEnabled)
+	{
+		state.auxFirstPhase = packet[16] >> 8;
+
+		for (int i = 0; i < NumSamples; i++)
+			state.auxSlots[i] = frame[i * frameWords];
+	}
+}
+
+// one row per entry of RCB_CHANNEL_COUNTS / RCB_SAMPLES_PER_PACKET, aux off and on
+static const RcbDecodeFunction specializedDecoders[RCB_NUM_PACKET_FORMATS][2] =
+{
+	{ decodePacketSpecialized<32, 21, false>, decodePacketSpecialized<32, 21, true> },
+	{ decodePacketSpecialized<28, 23, false>, decodePacketSpecialized<28, 23, true> },
+	{ decodePacketSpecialized<24, 27, false>, decodePacketSpecialized<24, 27, true> },
+	{ decodePacketSpecialized<20, 32, false>, decodePacketSpecialized<20, 32, true> },
+	{ decodePacketSpecialized<16, 39, false>, decodePacketSpecialized<16, 39, true> },
+	{ decodePacketSpecialized<12, 51, false>, decodePacketSpecialized<12, 51, true> },
+	{ decodePacketSpecialized<8, 71, false>, decodePacketSpecialized<8, 71, true> },
+	{ decodePacketSpecialized<4, 119, false>, decodePacketSpecialized<4, 119, true> }
+};
+
+RcbDecodeFunction RcbWifiNode::getSpecializedDecoder(int numChannels, int numSamples, bool auxEnabled)
+{
+	for (int format = 0; format < RCB_NUM_PACKET_FORMATS; format++)
+	{
+		if (RCB_CHANNEL_COUNTS[format] == numChannels && RCB_SAMPLES_PER_PACKET[format] == numSamples)
+			return specializedDecoders[format][auxEnabled ? 1 : 0];
+	}
+
+	return nullptr;
+}
+
+RcbDecodeFunction RcbWifiNode::selectDecoder(int numChannels, int numSamples, bool auxEnabled)
+{
+	RcbDecodeFunction decoder = getSpecializedDecoder(numChannels, numSamples, auxEnabled);
+
+	return decoder != nullptr ? decoder : decodePacketGeneric;
+}
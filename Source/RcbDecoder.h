@@ -0,0 +1,63 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBDECODERH__
+#define __RCBDECODERH__
+
+#include "RcbPacket.h"
+
+namespace RcbWifiNode
+{
+    /** Settings and aux history used while decoding the packets of one stream */
+    struct RcbDecoderState
+    {
+        int numChannels = 0;
+        int numSamples = 0;
+        bool auxEnabled = false;
+
+        float scale = 0.195f;
+        uint16_t offset = 32768;
+
+        // with aux enabled, the raw aux slot of each frame of the last packet and the aux phase of its first frame
+        uint16_t auxSlots[RCB_MAX_SAMPLES_PER_PACKET];
+        int auxFirstPhase = 0;
+    };
+
+    /**
+        Converts the frames of one packet into dst, numSamples rows of numChannels amplifier samples.
+        With aux enabled the aux slots are kept in the state for RcbAuxDemux.
+    */
+    typedef void (*RcbDecodeFunction)(const uint16_t* packet, float* dst, RcbDecoderState& state);
+
+    /** Decoder for any packet geometry, uses the runtime dispatched conversion kernel */
+    void decodePacketGeneric(const uint16_t* packet, float* dst, RcbDecoderState& state);
+
+    /** Returns the decoder specialized for this channel count, packet size and aux state, or nullptr if there is none */
+    RcbDecodeFunction getSpecializedDecoder(int numChannels, int numSamples, bool auxEnabled);
+
+    /** Returns the specialized decoder when there is one, the generic decoder otherwise */
+    RcbDecodeFunction selectDecoder(int numChannels, int numSamples, bool auxEnabled);
+}
+
+#endif
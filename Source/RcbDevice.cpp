@@ -0,0 +1,514 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "RcbDevice.h"
+
+using namespace RcbWifiNode;
+
+RcbDevice::RcbDevice() : packetRing(PACKET_RING_SIZE)
+{
+}
+
+RcbDevice::~RcbDevice()
+{
+	disconnect();
+}
+
+bool RcbDevice::connect()
+{
+	// if socket is open, shut it down and start fresh
+	disconnect();
+
+	socket = std::make_unique<DatagramSocket>();
+	socket->setEnablePortReuse(true);
+	connected = socket->bindToPort(port);
+
+	if (connected)
+	{
+		LOGC("[dspw] Socket bound to port ", port);
+	}
+	else {
+		LOGC("[dspw] Could not bind socket to port ", port);
+	}
+
+	return connected;
+}
+
+void RcbDevice::disconnect()
+{
+	if (socket != nullptr)
+	{
+		socket->shutdown();
+		socket.reset();
+	}
+
+	connected = false;
+}
+
+bool RcbDevice::resizeBuffers(DataBuffer* buffer, DataBuffer* auxBuffer, DataBuffer* lfpBuffer, float dataScale, uint16_t dataOffset)
+{
+	// aux inputs go to their own stream, the amplifier stream carries only the amplifier channels
+	const bool auxEnabled = auxBuffer != nullptr;
+	numOutChannels = numChannels;
+
+	// the writer stages a whole batch of packets
+	bool allocated = writer.setBuffer(buffer, numOutChannels, RECV_BATCH_SIZE * numSamples);
+	reference.setup(referenceMode, referenceMask, numChannels);
+	filters.setup(filterSettings, sampleRate, numChannels);
+	writer.setFilter(&filters);
+	spikeDetector.setup(spikeSettings, sampleRate, numChannels);
+	writer.setSpikeDetector(&spikeDetector, RCB_TTL_SPIKE_FIRST_LINE);
+	setTtlDebounce(ttlDebounceMs);
+	auxDemux.setup(RCB_AUX_SCALE, writer.getCapacity());
+	writer.setAuxDemux(&auxDemux, auxBuffer);
+	lfp.setup(lfpBuffer != nullptr ? lfpFactor : 0, numChannels, writer.getCapacity());
+	writer.setDecimator(&lfp, lfpBuffer, sampleRate);
+
+	allocated = gapArena.allocate(RcbArena::bytesFor<float>(numOutChannels * numSamples) + RcbArena::bytesFor<float>(numOutChannels)) && allocated;
+	gapNextFrames = gapArena.take<float>(numOutChannels * numSamples);
+	gapLastFrame = gapArena.take<float>(numOutChannels);
+
+	// pick the packet decoder for this channel count and aux state once, outside the hot loop
+	decoderState.numChannels = numChannels;
+	decoderState.numSamples = numSamples;
+	decoderState.auxEnabled = auxEnabled;
+	decoderState.scale = dataScale;
+	decoderState.offset = dataOffset;
+	decodePacket = selectDecoder(numChannels, numSamples, auxEnabled);
+
+	if (!allocated)
+		LOGC("[dspw] port-", String(port), "  could not allocate ", String(numOutChannels), " x ", String(numSamples), " sample buffers");
+
+	return allocated;
+}
+
+void RcbDevice::resetCounters()
+{
+	packetRing.reset();
+
+	seqNum = 0;
+	firstPacket = 1;
+	sequence.restart();
+	concealed = 0;
+	shortPackets = 0;
+	writer.reset();
+
+	reorder.reset();
+	filters.reset();
+	auxDemux.reset();
+	auxDemux.clearNumDropped();
+	lfp.reset();
+	spikeDetector.reset();
+	clock.reset(sampleRate);
+	telemetry.reset();
+	log.reset();
+	numLogDroppedReported = 0;
+	lastRxTicks = 0;
+
+	total_samples = 0;  // reset sampleNumbers used in processPacket()
+	seqSampleBase = 0;
+	ttl.reset();  // reset TTL event state
+}
+
+int RcbDevice::processPackets(bool& ok)
+{
+	const RcbPacketSlot* slots;
+	int numPackets = packetRing.getReadySlots(&slots, RECV_BATCH_SIZE);
+
+	if (numPackets == 0)
+		return 0;
+
+	telemetry.ringDepth.add(packetRing.getNumReady());
+
+	const int packetBytes = rcbPacketBytes(numChannels, numSamples);
+
+	// the slots are released before the push, keep their receive times for the latency
+	int64 rxTicks[RECV_BATCH_SIZE];
+
+	for (int p = 0; p < numPackets; p++)
+	{
+		rxTicks[p] = slots[p].rxTicks;
+
+		// packets of one recvmmsg() share a receive time, so those show up as 0
+		if (lastRxTicks != 0)
+			telemetry.interArrivalUs.add(uint64(jmax((int64)0, slots[p].rxTicks - lastRxTicks) * ticksToNs * 0.001));
+		lastRxTicks = slots[p].rxTicks;
+
+		// a truncated datagram, or one for other settings, would be decoded past its end. its samples are lost
+		if (slots[p].length < packetBytes)
+		{
+			shortPackets++;
+			log.push(RcbLogCode::SHORT_PACKET, slots[p].length, (uint64_t)packetBytes);
+			continue;
+		}
+
+		const uint16_t* packet = slots[p].data;
+		bool good;
+
+		// bad packets go straight to processPacket() to be reported
+		if (reorder.getSize() > 0 && (packet[0] & 0x00ff) == RCB_MAGIC_NUM)
+		{
+			uint32_t sn = ((uint32_t)packet[5] << 16) + packet[4];
+
+			if (reorder.isTooLate(sn))
+				sequence.delayed++;
+
+			good = reorder.push(slots[p], sn, [this](const uint16_t* data, int64 rxTicks) { return processPacket(data, rxTicks); });
+		}
+		else
+		{
+			good = processPacket(packet, slots[p].rxTicks);
+		}
+
+		if (!good)
+		{
+			log.push(RcbLogCode::BAD_MAGIC, packet[0]);
+			ok = false;
+		}
+	}
+
+	packetRing.release(numPackets);
+
+	// push the whole batch to the DataBuffer at once
+	int64 pushStart = Time::getHighResolutionTicks();
+	writer.flush();
+	int64 pushEnd = Time::getHighResolutionTicks();
+	telemetry.pushUs.add(uint64((pushEnd - pushStart) * ticksToNs * 0.001));
+
+	for (int p = 0; p < numPackets; p++)
+		telemetry.rxToBufferUs.add(uint64(jmax((int64)0, pushEnd - rxTicks[p]) * ticksToNs * 0.001));
+
+	publishCounts();
+
+	return numPackets;
+}
+
+void RcbDevice::flushLog()
+{
+	static_assert((int)RcbLogCode::NUM_CODES == 6, "format the new log code below");
+
+	RcbLogEntry entry;
+
+	while (log.pop(entry))
+	{
+		String suppressed = entry.numSuppressed > 0 ? "  (" + String(entry.numSuppressed) + " more not logged)" : String();
+
+		switch (entry.code)
+		{
+		case RcbLogCode::FIRST_PACKET:
+			if (entry.a == 1)
+				LOGC("[dspw] UDP Port - ", String(port), "  First seqNum = ", String::toHexString((int64)entry.a));
+
+			LOGD("[dspw] mNum = ", String::toHexString((int)(entry.b & 0x00ff)));
+			LOGD("[dspw] sod = ", String::toHexString((int)entry.b));
+			LOGD("[dspw] port-", String(port), "  seqNum = ", String::toHexString((int64)entry.a), suppressed);
+			break;
+
+		case RcbLogCode::DELAYED_PACKET:
+			LOGD("[dspw] port-", String(port), "  delayed seqNum = ", String::toHexString((int64)entry.a), suppressed);
+			break;
+
+		case RcbLogCode::BAD_MAGIC:
+			LOGC("[dspw] RCB WiFi : Fail Packet MagicNum test. port-", String(port), "  sod = ", String::toHexString((int)entry.a), suppressed);
+			break;
+
+		case RcbLogCode::GAP_TOO_LONG:
+			LOGC("[dspw] port-", String(port), "  gap of ", String((int64)entry.a), " packets too long to conceal", suppressed);
+			break;
+
+		case RcbLogCode::SHORT_PACKET:
+			LOGC("[dspw] port-", String(port), "  dropped a ", String((int64)entry.a), " byte packet, expected ",
+				String((int64)entry.b), " bytes for the channel and sample settings", suppressed);
+			break;
+
+		case RcbLogCode::RESTART:
+			LOGC("[dspw] port-", String(port), "  RCB restarted its sequence at seqNum ", String((int64)entry.a),
+				", expected ", String((int64)entry.b), ", sample numbers continue", suppressed);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	if (log.getNumDropped() != numLogDroppedReported)
+	{
+		numLogDroppedReported = log.getNumDropped();
+		LOGD("[dspw] port-", String(port), "  ", String(numLogDroppedReported), " log entries dropped on a full queue");
+	}
+}
+
+void RcbDevice::setFilters(const RcbFilterSettings& settings)
+{
+	filterSettings = settings;
+	filters.setup(filterSettings, sampleRate, numChannels);
+
+	LOGD("[dspw] port-", String(port), "  filter sections = ", filters.getNumSections());
+}
+
+void RcbDevice::setReference(RcbReferenceMode mode, uint32_t groupMask)
+{
+	referenceMode = mode;
+	referenceMask = groupMask;
+	reference.setup(referenceMode, referenceMask, numChannels);
+}
+
+void RcbDevice::setTtlDebounce(float ms)
+{
+	ttlDebounceMs = ms;
+	ttl.setup(int(ms * 0.001f * sampleRate + 0.5f));
+}
+
+void RcbDevice::setSpikeDetection(const RcbSpikeSettings& settings)
+{
+	spikeSettings = settings;
+	spikeDetector.setup(spikeSettings, sampleRate, numChannels);
+}
+
+void RcbDevice::setReorderWindow(int numPackets)
+{
+	reorder.setSize(numPackets);
+
+	LOGD("[dspw] port-", String(port), "  reorder window = ", reorder.getSize(), " packets");
+}
+
+String RcbDevice::getReorderStats() const
+{
+	const RcbStreamCounts counts = getCounts();
+	const uint32_t* reorderHist = counts.reorderDepth;
+	String stats;
+
+	for (int i = 0; i < RCB_REORDER_HIST_SIZE; i++)
+	{
+		if (reorderHist[i] == 0)
+			continue;
+
+		if (i == RCB_REORDER_HIST_SIZE - 1)
+			stats << "late:" << String(reorderHist[i]);
+		else if (i == RCB_REORDER_HIST_SIZE - 2)
+			stats << String(i) << "+:" << String(reorderHist[i]) << " ";
+		else
+			stats << String(i) << ":" << String(reorderHist[i]) << " ";
+	}
+
+	return stats.trimEnd();
+}
+
+void RcbDevice::concealGap(int numGapSamples, const float* nextFrame)
+{
+	const int chunkSize = writer.getCapacity();
+	const uint64 ttlWord = ttl.getState() | (1ULL << RCB_TTL_CONCEAL_LINE);
+
+	float* last = gapLastFrame;
+	writer.getLastFrame(last);
+
+	for (int done = 0; done < numGapSamples; done += chunkSize)
+	{
+		int chunk = std::min(chunkSize, numGapSamples - done);
+
+		float* frames = writer.reserve(chunk);
+		int64* sampleNums = writer.getSampleNumbers();
+		uint64* ttlWords = writer.getEventWords();
+
+		if (concealMode == RcbConcealMode::ZERO)
+		{
+			std::fill(frames, frames + chunk * numOutChannels, 0.0f);
+		}
+		else if (concealMode == RcbConcealMode::HOLD)
+		{
+			for (int f = 0; f < chunk; f++)
+				std::copy(last, last + numOutChannels, frames + f * numOutChannels);
+		}
+		else
+		{
+			const float step = 1.0f / float(numGapSamples + 1);
+
+			for (int f = 0; f < chunk; f++)
+			{
+				float t = float(done + f + 1) * step;
+				float* row = frames + f * numOutChannels;
+
+				for (int c = 0; c < numOutChannels; c++)
+					row[c] = last[c] + t * (nextFrame[c] - last[c]);
+			}
+		}
+
+		for (int f = 0; f < chunk; f++)
+			sampleNums[f] = total_samples + f;
+		std::fill(ttlWords, ttlWords + chunk, ttlWord);
+		clock.getTimestamps(total_samples, chunk, writer.getTimestamps());
+
+		writer.commit(chunk);
+		total_samples += chunk;
+	}
+}
+
+void RcbDevice::publishCounts()
+{
+	RcbStreamCounts counts;
+	counts.seqNum = seqNum;
+	counts.hit = sequence.hit;
+	counts.miss = sequence.miss;
+	counts.delayed = sequence.delayed;
+	counts.restarts = sequence.restarts;
+	counts.concealed = concealed;
+	counts.shortPackets = shortPackets;
+	counts.auxDropped = auxDemux.getNumDropped();
+
+	counts.clockLocked = clock.isLocked();
+	counts.driftPpm = clock.getDriftPpm();
+	counts.jitter = clock.getJitter();
+	counts.clockRejected = clock.getNumRejected();
+	counts.clockResyncs = clock.getNumResyncs();
+	std::copy(reorder.getHistogram(), reorder.getHistogram() + RCB_REORDER_HIST_SIZE, counts.reorderDepth);
+
+	telemetry.counts.publish(counts);
+}
+
+void RcbDevice::restartSequence(uint32_t firstSeqNum)
+{
+	// the old sequence's samples go out first, the new one continues the sample numbers from here
+	writer.flush();
+	sequence.restartSequence();
+	seqSampleBase = total_samples - (int64)numSamples * ((int64)firstSeqNum - 1);
+
+	// a rebooted RCB has a new sample clock and aux phase
+	clock.resync();
+	auxDemux.reset();
+}
+
+bool RcbDevice::processPacket(const uint16_t* packet, int64 rxTicks)
+{
+    magicNum = (uint8_t)(packet[0] & 0x00ff);
+    // LOGD("[dspw] mNum = ",(String::toHexString(magicNum)));
+    sod = (packet[0]);// &0x00ff);
+
+	if (magicNum == RCB_MAGIC_NUM) // is a good packet
+	{
+		seqNum = ((uint32_t)packet[5] << 16) + packet[4];
+		auxMask = (uint8_t)(packet[16] & 0x00ff);
+		auxPhase = (uint8_t)(packet[16] >> 8);
+		batteryVolts = packet[18]; // battery voltage
+        digInputs = packet[19];  // state of digital inputs.  connect to OE TTL Events
+
+		if (firstPacket == 1)
+		{
+            // might need to indicate to user and stop acq if packet containing seqnum = 1 is lost
+            // however does not happen in testing.
+			if (seqNum == 1)
+				firstPacket = 0;
+
+			sequence.restart(seqNum); //macos
+
+			log.push(RcbLogCode::FIRST_PACKET, seqNum, sod);
+		}
+
+		// a re-init or reboot of the RCB starts its seqNums over, far behind the expected one
+		if (sequence.isRestart(seqNum))
+		{
+			log.push(RcbLogCode::RESTART, seqNum, sequence.nextSeqNum);
+			restartSequence(seqNum);
+		}
+
+		int64 counted = sequence.count(seqNum);
+		uint32_t lostPackets = counted > 0 ? (uint32_t)counted : 0;
+
+		if (counted < 0) {
+			log.push(RcbLogCode::DELAYED_PACKET, seqNum);
+
+			// late by at most RCB_LATE_PACKETS and its samples were already concealed, drop it so sample numbers keep increasing
+			if (concealMode != RcbConcealMode::OFF)
+				return true;
+
+			sequence.resync(seqNum); // macos
+		}
+
+		if (lostPackets > 0)
+			telemetry.lossBurst.add(lostPackets);
+
+		bool conceal = lostPackets > 0 && concealMode != RcbConcealMode::OFF
+			&& (int64)lostPackets * numSamples <= RCB_MAX_CONCEAL_SAMPLES;
+
+		if (conceal)
+		{
+			// decode ahead so LINEAR can ramp to the first sample after the gap, the gap goes out first
+			int64 decodeStart = Time::getHighResolutionTicks();
+			decodePacket(packet, gapNextFrames, decoderState);
+			reference.process(gapNextFrames, numOutChannels, numSamples);
+			telemetry.decodeNs.add(uint64((Time::getHighResolutionTicks() - decodeStart) * ticksToNs));
+			concealGap((int)lostPackets * numSamples, gapNextFrames);
+			concealed += lostPackets;
+
+			std::copy(gapNextFrames, gapNextFrames + numOutChannels * numSamples, writer.reserve(numSamples));
+		}
+		else
+		{
+			// convert and transpose the whole packet at once, straight into the DataBuffer writer, and re-reference it while it is in cache
+			float* frames = writer.reserve(numSamples);
+			int64 decodeStart = Time::getHighResolutionTicks();
+			decodePacket(packet, frames, decoderState);
+			reference.process(frames, numOutChannels, numSamples);
+			telemetry.decodeNs.add(uint64((Time::getHighResolutionTicks() - decodeStart) * ticksToNs));
+		}
+
+		if (!conceal && lostPackets > 0)
+		{
+			// no fill, sample numbers jump over the lost packets
+			if (concealMode == RcbConcealMode::OFF)
+				total_samples = seqSampleBase + (int64)numSamples * (seqNum - 1);
+			else
+			{
+				log.push(RcbLogCode::GAP_TOO_LONG, lostPackets);
+				total_samples += (int64)numSamples * lostPackets;
+			}
+		}
+
+		int64* sampleNums = writer.getSampleNumbers();
+		uint64* ttlWords = writer.getEventWords();
+
+		// fit the sample clock to the receive time of the packet's last sample, then timestamp its samples
+		clock.addPacket(total_samples + numSamples, Time::highResolutionTicksToSeconds(rxTicks));
+		clock.getTimestamps(total_samples, numSamples, writer.getTimestamps());
+
+		for (int i = 0; i < numSamples; i++)
+			sampleNums[i] = total_samples + i;
+
+		if (decoderState.auxEnabled)
+			auxDemux.process(decoderState.auxSlots, numSamples, decoderState.auxFirstPhase, sampleNums, writer.getTimestamps());
+
+		// the inputs are reported once per packet, changes land on their packet's first sample or where the debounce ends
+		ttl.update(digInputs, total_samples, numSamples, ttlWords, 0);
+
+		writer.commit(numSamples);
+
+		// concealed gaps keep the count continuous
+		if (concealMode == RcbConcealMode::OFF)
+			total_samples = seqSampleBase + (int64)numSamples * seqNum;
+		else
+			total_samples += numSamples;
+
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,260 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBDEVICEH__
+#define __RCBDEVICEH__
+
+#include <DataThreadHeaders.h>
+
+#include "RcbBufferWriter.h"
+#include "RcbClockRecovery.h"
+#include "RcbDecoder.h"
+#include "RcbLogQueue.h"
+#include "RcbPacketRing.h"
+#include "RcbReference.h"
+#include "RcbSpikeDetector.h"
+#include "RcbTtlInput.h"
+#include "RcbSequence.h"
+#include "RcbTelemetry.h"
+
+// Samples held by each device's DataBuffer
+const int DATA_BUFFER_SIZE = 30000;
+
+// Longest packet gap that is concealed; a longer one (e.g. RCB restart) is left as a sample number jump
+const int RCB_MAX_CONCEAL_SAMPLES = DATA_BUFFER_SIZE / 2;
+
+// TTL lines of each device stream.  Lines 0-7 are the RCB digital inputs
+const int RCB_NUM_TTL_LINES = 16;
+
+// TTL line that is high on samples filled in for lost packets
+const int RCB_TTL_CONCEAL_LINE = 8;
+
+// With spike detection on, line RCB_TTL_SPIKE_FIRST_LINE + channel pulses for one sample on each spike
+const int RCB_TTL_SPIKE_FIRST_LINE = RCB_NUM_TTL_LINES;
+
+namespace RcbWifiNode
+{
+    /** How samples of lost packets are filled in */
+    enum class RcbConcealMode
+    {
+        OFF,        // no fill, sample numbers jump over the lost packets
+        ZERO,       // zeros
+        HOLD,       // last received sample repeated
+        LINEAR      // straight line from the last sample before the gap to the first one after it
+    };
+
+    /**
+        One RCB module streaming to this plugin: its descriptor (IP, port, channel mask),
+        UDP socket, packet ring and packet accounting.  Each device is published as its own DataStream.
+    */
+    class RcbDevice
+    {
+    public:
+        /** Constructor */
+        RcbDevice();
+
+        /** Destructor */
+        ~RcbDevice();
+
+        /** Device descriptor */
+        String ipNumStr = "";
+        int port = 0;
+        int numChannels = 0;
+        int chShift = 1;    // first RHD channel, 1 based
+
+        /** Stream parameters, derived from numChannels and the desired sample rate */
+        int numSamples = 0;
+        float sampleRate = 0;
+        uint32_t bitrate = 0;
+
+        /** Loss concealment for this device's stream */
+        RcbConcealMode concealMode = RcbConcealMode::ZERO;
+
+        /** Filters the amplifier channels on the host before the DataBuffer. Only call when not acquiring */
+        void setFilters(const RcbFilterSettings& settings);
+        RcbFilterSettings filterSettings;
+
+        /** Re-references the amplifier channels to the mean or median of the channels in groupMask, 0 for all. Only call when not acquiring */
+        void setReference(RcbReferenceMode mode, uint32_t groupMask);
+        RcbReferenceMode referenceMode = RcbReferenceMode::OFF;
+        uint32_t referenceMask = 0;
+
+        /** Digital input changes shorter than this are dropped as glitches, ms. Only call when not acquiring */
+        void setTtlDebounce(float ms);
+        float ttlDebounceMs = 0;
+        const RcbTtlInput& getTtlInput() const { return ttl; }
+
+        /** Decimation factor of the LFP stream, 0 for none.  Used by resizeBuffers() */
+        int lfpFactor = 0;
+
+        /** Detects spikes on the amplifier channels after the filters. Only call when not acquiring */
+        void setSpikeDetection(const RcbSpikeSettings& settings);
+        RcbSpikeSettings spikeSettings;
+        const RcbSpikeDetector& getSpikeDetector() const { return spikeDetector; }
+
+        /**
+            Holds out of order packets for up to numPackets packets and releases them in sequence.
+            0 turns reordering off.  Only call when not acquiring.
+        */
+        void setReorderWindow(int numPackets);
+        int getReorderWindow() const { return reorder.getSize(); }
+
+        /** Reorder depth distribution as of the last batch, as "depth:count ...".  Any thread */
+        String getReorderStats() const;
+
+        /** Binds the UDP socket to port, closing any previous socket */
+        bool connect();
+
+        /** Closes the UDP socket */
+        void disconnect();
+
+        /**
+            Sets the DataBuffer this device writes to, the one its aux stream goes to when auxBuffer is not nullptr,
+            and the one its LFP stream goes to if lfpFactor is set, sizes the conversion buffers and picks the packet decoder.
+            Everything the streaming path needs is allocated here.  Returns false if it could not be.
+        */
+        bool resizeBuffers(DataBuffer* buffer, DataBuffer* auxBuffer, DataBuffer* lfpBuffer, float dataScale, uint16_t dataOffset);
+
+        /** Resets packet accounting at the start of acquisition */
+        void resetCounters();
+
+        /**
+            Converts the packets waiting in the ring and pushes them to the DataBuffer as one block.
+            Returns the number of packets consumed; ok is cleared if a packet failed the magic number test.
+        */
+        int processPackets(bool& ok);
+
+        /** Writes what the streaming path queued for the log. Call from the message thread */
+        void flushLog();
+
+        /** UDP socket object */
+        std::unique_ptr<DatagramSocket> socket;
+
+        /** Socket receive buffer the OS granted at the last start, bytes */
+        int receiveBufferBytes = 0;
+
+        /** SO_BUSY_POLL time the OS granted at the last start, microseconds */
+        int busyPollUs = 0;
+
+        /** True if socket is bound */
+        bool connected = false;
+
+        /** Packets received by the socket reader thread, waiting to be converted */
+        RcbPacketRing packetRing;
+
+        /** Timing and loss histograms since the start of acquisition, readable from any thread */
+        RcbTelemetry telemetry;
+
+        /**
+            seqNum, sequence counters, clock fit and reorder depths as of the last batch, for other
+            threads than the DataThread.  reorderDepth counts packets by how far behind the newest
+            one they arrived, its last bucket those too late for the window.
+        */
+        RcbStreamCounts getCounts() const { return telemetry.counts.get(); }
+
+        // UDP Packet, written by the DataThread
+        uint8_t magicNum = 0;
+        uint32_t seqNum = 0;
+        RcbSequenceCounter sequence;    // hit, miss and delayed packets
+        uint32_t concealed = 0;   // packets filled in
+        uint32_t shortPackets = 0;  // datagrams shorter than the settings need, dropped
+        uint16_t digInputs = 0;
+        uint16_t sod = 0;
+        bool firstPacket = 1;
+
+        uint16_t batteryVolts = 0;
+        uint8_t auxPhase = 0;
+        uint8_t auxMask = 0;
+
+    private:
+        /** Parses one RCB packet and writes its samples, timestamped from its host receive time */
+        bool processPacket(const uint16_t* packet, int64 rxTicks);
+
+        /**
+            Writes numGapSamples concealed samples, in chunks of at most a whole batch.
+            nextFrame is the first sample after the gap, used for LINEAR.
+        */
+        void concealGap(int numGapSamples, const float* nextFrame);
+
+        /** Sample index counter */
+        int64 total_samples = 0;
+
+        /** Sample number of seqNum 0 of the current RCB sequence, moves when the RCB restarts its sequence */
+        int64 seqSampleBase = 0;
+
+        /** Continues the sample timeline after the RCB restarted its sequence at firstSeqNum */
+        void restartSequence(uint32_t firstSeqNum);
+
+        /** Copies seqNum and the sequence counters to telemetry.counts */
+        void publishCounts();
+
+        /** Receive time of the previous packet, for the inter-arrival histogram */
+        int64 lastRxTicks = 0;
+        const double ticksToNs = 1e9 / double(Time::getHighResolutionTicksPerSecond());
+
+        /** Debounced digital inputs, fills the TTL words of each packet */
+        RcbTtlInput ttl;
+
+        /** Packet decoder for the current channel count and aux state, set in resizeBuffers() */
+        RcbDecodeFunction decodePacket = decodePacketGeneric;
+        RcbDecoderState decoderState;
+
+        /** Maps sample numbers to host time */
+        RcbClockRecovery clock;
+
+        /** Converted samples go straight into the writer's block, RECV_BATCH_SIZE packets at a time */
+        RcbBufferWriter writer;
+        int numOutChannels = 0;
+
+        /** Packet after a gap, decoded ahead of the concealed samples */
+        RcbArena gapArena;
+        float* gapNextFrames = nullptr;
+        float* gapLastFrame = nullptr;  // last sample before the gap
+
+        /** Re-referencing, run on each packet right after decode */
+        RcbReference reference;
+
+        /** On-host filters, run by the writer on each block it pushes */
+        RcbFilterBank filters;
+
+        /** Aux inputs at a quarter of the sample rate, fed with the aux slots of each decoded packet */
+        RcbAuxDemux auxDemux;
+
+        /** LFP decimation, run by the writer before the filters */
+        RcbDecimator lfp;
+
+        /** Spike detection, run by the writer after the filters */
+        RcbSpikeDetector spikeDetector;
+
+        /** Log entries from the streaming path, formatted by flushLog() */
+        RcbLogQueue log;
+        uint32_t numLogDroppedReported = 0;
+
+        /** Reorder window in front of processPacket() */
+        RcbReorderWindow reorder;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RcbDevice);
+    };
+}
+#endif
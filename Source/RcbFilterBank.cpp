@@ -0,0 +1,128 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "RcbFilterBank.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace RcbWifiNode;
+
+static const double pi = 3.14159265358979323846;
+
+void RcbFilterBank::setup(const RcbFilterSettings& settings, double sampleRate, int numChans)
+{
+	numSections = 0;
+	numChannels = std::min(std::max(numChans, 0), RCB_FILTER_MAX_CHANNELS);
+
+	if (sampleRate > 0)
+	{
+		// Butterworth as cascaded 2nd order sections, Q of each from the pole angles
+		if (settings.highPassHz > 0 && settings.highPassHz < 0.45 * sampleRate)
+		{
+			const int order = settings.highPassOrder >= 4 ? 4 : 2;
+
+			for (int k = 0; k < order / 2; k++)
+				addHighPass(sampleRate, settings.highPassHz, 1.0 / (2.0 * std::sin((2 * k + 1) * pi / (2 * order))));
+		}
+
+		if (settings.notchHz > 0)
+		{
+			for (int h = 1; h <= settings.notchHarmonics && h * settings.notchHz < 0.45 * sampleRate; h++)
+				addNotch(sampleRate, h * settings.notchHz, std::max(settings.notchQ, 1.0f));
+		}
+	}
+
+	state.assign((size_t)numSections * 2 * numChannels, 0.0);
+}
+
+void RcbFilterBank::reset()
+{
+	std::fill(state.begin(), state.end(), 0.0);
+}
+
+// RBJ audio EQ cookbook designs, normalized to a0 = 1
+void RcbFilterBank::addHighPass(double sampleRate, double hz, double q)
+{
+	if (numSections == RCB_FILTER_MAX_SECTIONS)
+		return;
+
+	const double w0 = 2.0 * pi * hz / sampleRate;
+	const double cosw = std::cos(w0);
+	const double alpha = std::sin(w0) / (2.0 * q);
+	const double a0 = 1.0 + alpha;
+
+	sections[numSections++] = { (1.0 + cosw) / 2.0 / a0, -(1.0 + cosw) / a0, (1.0 + cosw) / 2.0 / a0,
+		-2.0 * cosw / a0, (1.0 - alpha) / a0 };
+}
+
+void RcbFilterBank::addNotch(double sampleRate, double hz, double q)
+{
+	if (numSections == RCB_FILTER_MAX_SECTIONS)
+		return;
+
+	const double w0 = 2.0 * pi * hz / sampleRate;
+	const double cosw = std::cos(w0);
+	const double alpha = std::sin(w0) / (2.0 * q);
+	const double a0 = 1.0 + alpha;
+
+	sections[numSections++] = { 1.0 / a0, -2.0 * cosw / a0, 1.0 / a0, -2.0 * cosw / a0, (1.0 - alpha) / a0 };
+}
+
+void RcbFilterBank::process(float* frames, int stride, int numFrames)
+{
+	if (numSections == 0)
+		return;
+
+	const int n = numChannels;
+	double x[RCB_FILTER_MAX_CHANNELS];
+
+	for (int f = 0; f < numFrames; f++)
+	{
+		float* row = frames + (size_t)f * stride;
+
+		// the tiny offset keeps decaying state out of denormals, e.g. while lost packets are filled with zeros
+		for (int c = 0; c < n; c++)
+			x[c] = row[c] + 1e-20;
+
+		// transposed direct form II, one section across all channels at a time
+		for (int s = 0; s < numSections; s++)
+		{
+			const Section k = sections[s];
+			double* z1 = state.data() + (size_t)(2 * s) * n;
+			double* z2 = z1 + n;
+
+			for (int c = 0; c < n; c++)
+			{
+				const double y = k.b0 * x[c] + z1[c];
+				z1[c] = k.b1 * x[c] - k.a1 * y + z2[c];
+				z2[c] = k.b2 * x[c] - k.a2 * y;
+				x[c] = y;
+			}
+		}
+
+		for (int c = 0; c < n; c++)
+			row[c] = (float)x[c];
+	}
+}
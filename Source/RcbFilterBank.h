@@ -0,0 +1,99 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBFILTERBANKH__
+#define __RCBFILTERBANKH__
+
+#include <cstdint>
+#include <vector>
+
+// Most channels one filter bank processes, the largest RCB channel count
+const int RCB_FILTER_MAX_CHANNELS = 32;
+
+// Most biquad sections: a 4th order high-pass and the notch harmonics
+const int RCB_FILTER_MAX_SECTIONS = 12;
+
+namespace RcbWifiNode
+{
+    /** On-host filtering of the amplifier channels, 0 turns a filter off */
+    struct RcbFilterSettings
+    {
+        float highPassHz = 0;       // Butterworth high-pass cutoff
+        int highPassOrder = 2;      // 2 or 4
+        float notchHz = 0;          // line frequency, 50 or 60
+        int notchHarmonics = 1;     // notches at notchHz and its multiples, below 0.45 of the sample rate
+        float notchQ = 30;          // notch frequency / width
+
+        bool operator==(const RcbFilterSettings& other) const
+        {
+            return highPassHz == other.highPassHz && highPassOrder == other.highPassOrder && notchHz == other.notchHz
+                && notchHarmonics == other.notchHarmonics && notchQ == other.notchQ;
+        }
+    };
+
+    /**
+        Cascade of biquad sections run on every channel of a block of samples.
+
+        Samples come sample-major, a row of channels per sample, so each section runs across the
+        channels of a row in one loop the compiler vectorizes.  The section state is kept
+        structure-of-arrays, one contiguous array per state variable with one entry per channel,
+        to match.  Coefficients and state are double, so a high-pass cutoff near 1 Hz at 30 kS/s
+        stays stable; samples stay float.
+    */
+    class RcbFilterBank
+    {
+    public:
+        /** Designs the sections for the sample rate and clears the state. Allocates, only call when not streaming */
+        void setup(const RcbFilterSettings& settings, double sampleRate, int numChannels);
+
+        /** Clears the filter state, e.g. at the start of acquisition */
+        void reset();
+
+        /** True if there is at least one section to run */
+        bool isActive() const { return numSections > 0; }
+
+        int getNumSections() const { return numSections; }
+
+        /** Filters the first numChannels floats of numFrames rows, rows are stride floats apart */
+        void process(float* frames, int stride, int numFrames);
+
+    private:
+        struct Section
+        {
+            double b0, b1, b2, a1, a2;
+        };
+
+        void addHighPass(double sampleRate, double hz, double q);
+        void addNotch(double sampleRate, double hz, double q);
+
+        Section sections[RCB_FILTER_MAX_SECTIONS];
+        int numSections = 0;
+        int numChannels = 0;
+
+        // z1 and z2 of each section, numChannels entries each: z1 of section 0, z2 of section 0, z1 of section 1, ...
+        std::vector<double> state;
+    };
+}
+
+#endif
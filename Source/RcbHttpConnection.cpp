@@ -0,0 +1,324 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+#include "RcbHttpConnection.h"
+
+using namespace RcbWifiNode;
+
+#define RCB_HTTP_CONNECT_TIMEOUT_MS 2000
+#define RCB_HTTP_RESPONSE_TIMEOUT_MS 3000
+
+RcbHttpConnection::RcbHttpConnection(const String& host_, int port_) :
+	host(host_),
+	port(port_)
+{
+}
+
+RcbHttpConnection::~RcbHttpConnection()
+{
+	close();
+}
+
+void RcbHttpConnection::close()
+{
+	if (connected)
+		socket.close();
+
+	connected = false;
+	rxBuffer.clear();
+	rxPos = 0;
+}
+
+bool RcbHttpConnection::ensureConnected(int timeoutMs)
+{
+	if (connected)
+	{
+		// nothing is outstanding, so readable means the RCB closed the connection while idle
+		if (socket.waitUntilReady(true, 0) == 0)
+			return true;
+
+		close();
+	}
+
+	if (!socket.connect(host, port, timeoutMs))
+		return false;
+
+	connected = true;
+	numConnects++;
+
+	return true;
+}
+
+void RcbHttpConnection::exchange(const std::vector<const RcbHttpRequest*>& requests, std::vector<RcbResponse>& responses)
+{
+	responses.assign(requests.size(), RcbResponse());
+	std::vector<int64> sentTicks(requests.size(), 0);
+
+	size_t next = 0;    // first request without a response
+	size_t unsent = 0;  // first request not written to any connection yet
+	int retries = 0;
+
+	while (next < requests.size()
+		&& ensureConnected(requests[next]->timeoutMs > 0 ? requests[next]->timeoutMs : RCB_HTTP_CONNECT_TIMEOUT_MS))
+	{
+		// pipelined, everything left goes out at once, otherwise one request per round
+		const size_t first = next;
+		const size_t end = pipelining ? requests.size() : next + 1;
+		bool dropped = false;
+
+		for (size_t i = first; i < end && !dropped; i++)
+		{
+			// a failed write may still have got the whole request out
+			sentTicks[i] = Time::getHighResolutionTicks();
+			unsent = jmax(unsent, i + 1);
+			dropped = !writeRequest(*requests[i]);
+		}
+
+		for (size_t i = first; i < end && !dropped; i++)
+		{
+			bool keepAlive = true;
+			deadline = Time::getMillisecondCounter() + uint32(requests[i]->timeoutMs > 0 ? requests[i]->timeoutMs : RCB_HTTP_RESPONSE_TIMEOUT_MS);
+
+			if (!readResponse(responses[i], keepAlive))
+			{
+				dropped = true;
+				break;
+			}
+
+			responses[i].roundTripMs = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - sentTicks[i]) * 1000.0;
+			next = i + 1;
+
+			if (!keepAlive)
+			{
+				// the requests written after this one went with the connection
+				if (next < end)
+				{
+					LOGD("[dspw] RCB ", host, " closes connections, not pipelining");
+					pipelining = false;
+				}
+
+				close();
+				break;
+			}
+		}
+
+		if (dropped)
+		{
+			close();
+
+			// the RCB may have run an unanswered request before the drop, only GETs are safe to send again
+			bool unsafe = false;
+
+			for (size_t i = next; i < unsent && !unsafe; i++)
+				unsafe = requests[i]->isPost;
+
+			if (unsafe)
+			{
+				LOGD("[dspw] RCB ", host, " dropped the connection before answering a POST, not sending it again");
+				break;
+			}
+
+			// an RCB that answers some of the requests and then stalls does not pipeline
+			if (next > first)
+				pipelining = false;
+			else if (++retries > 1)
+				break;
+		}
+	}
+
+	for (size_t i = next; i < requests.size(); i++)
+		responses[i].text = i < unsent ? "No response!" : "Failed to connect!";
+}
+
+bool RcbHttpConnection::writeRequest(const RcbHttpRequest& request)
+{
+	std::string body = request.isPost ? request.postData.toStdString() : std::string();
+
+	String head = String(request.isPost ? "POST " : "GET ") + request.path + " HTTP/1.1\r\n"
+		+ "Host: " + host + "\r\n"
+		+ "Connection: keep-alive\r\n";
+
+	if (request.isPost)
+		head << "Content-Type: application/x-www-form-urlencoded\r\n"
+			<< "Content-Length: " << String((int)body.size()) << "\r\n";
+
+	std::string data = (head + "\r\n").toStdString() + body;
+
+	return socket.write(data.data(), (int)data.size()) == (int)data.size();
+}
+
+bool RcbHttpConnection::readResponse(RcbResponse& response, bool& keepAlive)
+{
+	std::string line;
+	StringPairArray headers;
+	int64 contentLength = -1;
+	bool chunked = false;
+
+	// skip interim 1xx responses
+	do
+	{
+		if (!readLine(line) || line.compare(0, 5, "HTTP/") != 0)
+			return false;
+
+		keepAlive = line.compare(0, 8, "HTTP/1.0") != 0;
+		response.statusCode = String(line).fromFirstOccurrenceOf(" ", false, false).getIntValue();
+		headers.clear();
+
+		while (readLine(line))
+		{
+			if (line.empty())
+				break;
+
+			String header = String::fromUTF8(line.data(), (int)line.size());
+			String key = header.upToFirstOccurrenceOf(":", false, false).trim();
+			String value = header.fromFirstOccurrenceOf(":", false, false).trim();
+
+			headers.set(key, headers[key].isEmpty() ? value : headers[key] + "," + value);
+
+			if (key.equalsIgnoreCase("Content-Length"))
+				contentLength = value.getLargeIntValue();
+			else if (key.equalsIgnoreCase("Transfer-Encoding"))
+				chunked = value.containsIgnoreCase("chunked");
+			else if (key.equalsIgnoreCase("Connection"))
+				keepAlive = !value.containsIgnoreCase("close") && (keepAlive || value.containsIgnoreCase("keep-alive"));
+		}
+
+		if (!line.empty())
+			return false;
+	}
+	while (response.statusCode >= 100 && response.statusCode < 200);
+
+	std::string body;
+
+	if (response.statusCode == 204 || response.statusCode == 304)
+	{
+		// no body
+	}
+	else if (chunked)
+	{
+		while (true)
+		{
+			if (!readLine(line))
+				return false;
+
+			int64 chunkSize = String(line).getHexValue64();
+
+			if (chunkSize == 0)
+			{
+				// trailers end with an empty line
+				while (readLine(line) && !line.empty()) {}
+				if (!line.empty())
+					return false;
+				break;
+			}
+
+			if (!readBody(body, chunkSize) || !readLine(line))
+				return false;
+		}
+	}
+	else if (contentLength >= 0)
+	{
+		if (!readBody(body, contentLength))
+			return false;
+	}
+	else
+	{
+		// body ends when the RCB closes the connection
+		keepAlive = false;
+		if (!readBody(body, -1))
+			return false;
+	}
+
+	response.ok = response.statusCode >= 200 && response.statusCode < 400;
+	response.text = "Status code: " + String(response.statusCode) + "\n"
+		+ "Response headers: " + "\n"
+		+ headers.getDescription() + "\n"
+		+ "----------------------------------------------------" + "\n"
+		+ String::fromUTF8(body.data(), (int)body.size());
+
+	return true;
+}
+
+bool RcbHttpConnection::readLine(std::string& line)
+{
+	while (true)
+	{
+		size_t eol = rxBuffer.find("\r\n", rxPos);
+
+		if (eol != std::string::npos)
+		{
+			line.assign(rxBuffer, rxPos, eol - rxPos);
+			rxPos = eol + 2;
+			return true;
+		}
+
+		if (receive() <= 0)
+			return false;
+	}
+}
+
+bool RcbHttpConnection::readBody(std::string& body, int64 numBytes)
+{
+	while (numBytes < 0 || int64(rxBuffer.size() - rxPos) < numBytes)
+	{
+		int numRead = receive();
+
+		if (numRead == 0 && numBytes < 0)
+			break;
+
+		if (numRead <= 0)
+			return false;
+	}
+
+	size_t length = numBytes < 0 ? rxBuffer.size() - rxPos : size_t(numBytes);
+	body.append(rxBuffer, rxPos, length);
+	rxPos += length;
+
+	return true;
+}
+
+int RcbHttpConnection::receive()
+{
+	// drop what has been parsed before reading more
+	if (rxPos > 0)
+	{
+		rxBuffer.erase(0, rxPos);
+		rxPos = 0;
+	}
+
+	int waitMs = int(deadline - Time::getMillisecondCounter());
+
+	if (waitMs <= 0 || socket.waitUntilReady(true, waitMs) != 1)
+		return -1;
+
+	char buffer[4096];
+	int numRead = socket.read(buffer, sizeof(buffer), false);
+
+	// 0 means the RCB closed the connection
+	if (numRead > 0)
+		rxBuffer.append(buffer, numRead);
+
+	return numRead;
+}
@@ -0,0 +1,118 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+#ifndef __RCBHTTPCONNECTIONH__
+#define __RCBHTTPCONNECTIONH__
+
+#include <DataThreadHeaders.h>
+
+#include <string>
+#include <vector>
+
+namespace RcbWifiNode
+{
+    /** Result of one request to an RCB web server */
+    struct RcbResponse
+    {
+        bool ok = false;            // the RCB answered
+        int statusCode = 0;
+        String text;                // status code, headers and page, as "Status code: 200\nResponse headers: ..."
+        double roundTripMs = 0;
+    };
+
+    /** One request to an RCB web server */
+    struct RcbHttpRequest
+    {
+        String path = "/";
+        String postData;
+        bool isPost = false;
+        int timeoutMs = 0;          // connect and response timeout, 0 for the default
+    };
+
+    /**
+        A kept-alive HTTP/1.1 connection to the web server of one RCB.
+
+        Requests are written back to back and their responses read in order.  If the RCB
+        drops the connection, it is reopened and the unanswered requests are sent again, unless
+        one of them is a POST the RCB may already have acted on; then the rest fail.
+        If the RCB closes the connection after each response, requests are sent one at a
+        time from then on.  Not thread safe, one thread uses a connection at a time.
+    */
+    class RcbHttpConnection
+    {
+    public:
+        /** Constructor */
+        RcbHttpConnection(const String& host, int port = 80);
+
+        /** Destructor */
+        ~RcbHttpConnection();
+
+        /** Sends the requests and fills in one response for each, blocking until all are answered or failed */
+        void exchange(const std::vector<const RcbHttpRequest*>& requests, std::vector<RcbResponse>& responses);
+
+        /** Closes the connection, the next exchange opens a new one */
+        void close();
+
+        /** Number of times the connection was opened */
+        int getNumConnects() const { return numConnects; }
+
+        /** False once the RCB has shown it closes the connection after each response */
+        bool isPipelining() const { return pipelining; }
+
+    private:
+        /** Opens the connection if it is closed, or was closed by the RCB while idle */
+        bool ensureConnected(int timeoutMs);
+
+        bool writeRequest(const RcbHttpRequest& request);
+
+        /** Reads one response.  keepAlive is false if the RCB closes the connection after it */
+        bool readResponse(RcbResponse& response, bool& keepAlive);
+
+        /** Reads up to and without the next CRLF */
+        bool readLine(std::string& line);
+
+        /** Reads numBytes of body, or until the connection closes if numBytes < 0 */
+        bool readBody(std::string& body, int64 numBytes);
+
+        /** Receives more bytes into rxBuffer.  Returns the number received, 0 if the connection closed, -1 on timeout */
+        int receive();
+
+        String host;
+        int port;
+
+        StreamingSocket socket;
+        bool connected = false;
+        bool pipelining = true;
+        int numConnects = 0;
+
+        std::string rxBuffer;
+        size_t rxPos = 0;
+        uint32 deadline = 0;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RcbHttpConnection);
+    };
+}
+
+#endif
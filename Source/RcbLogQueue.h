@@ -0,0 +1,147 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBLOGQUEUEH__
+#define __RCBLOGQUEUEH__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Entries held until the message thread formats them
+const int RCB_LOG_QUEUE_SIZE = 256;
+
+// Entries of one kind let through per second, the rest are counted and reported with the next one
+const int RCB_LOG_MAX_PER_SECOND = 10;
+
+namespace RcbWifiNode
+{
+    /** Things the streaming path reports */
+    enum class RcbLogCode : uint8_t
+    {
+        FIRST_PACKET,   // a: seqNum, b: start of data word
+        DELAYED_PACKET, // a: seqNum
+        BAD_MAGIC,      // a: start of data word
+        GAP_TOO_LONG,   // a: packets lost
+        RESTART,        // a: seqNum, b: seqNum expected
+        SHORT_PACKET,   // a: datagram bytes, b: bytes expected
+        NUM_CODES
+    };
+
+    struct RcbLogEntry
+    {
+        RcbLogCode code;
+        uint32_t numSuppressed;     // entries of this code dropped by the rate limit just before this one
+        uint64_t a;
+        uint64_t b;
+    };
+
+    /**
+        Single-producer / single-consumer lock-free queue of log entries.  The streaming thread
+        pushes plain codes and numbers, without building strings, allocating or taking a lock;
+        the message thread pops and formats them.  Each code is rate limited, and entries are
+        dropped, and counted, when the queue is full.
+    */
+    class RcbLogQueue
+    {
+    public:
+        /** Producer side */
+        void push(RcbLogCode code, uint64_t a = 0, uint64_t b = 0)
+        {
+            const int c = (int)code;
+            const int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+
+            if (nowMs - windowStartMs[c] >= 1000)
+            {
+                windowStartMs[c] = nowMs;
+                numInWindow[c] = 0;
+            }
+
+            if (numInWindow[c] >= RCB_LOG_MAX_PER_SECOND)
+            {
+                numSuppressed[c]++;
+                return;
+            }
+
+            const uint32_t h = head.load(std::memory_order_relaxed);
+
+            if (h - tail.load(std::memory_order_acquire) >= RCB_LOG_QUEUE_SIZE)
+            {
+                numDropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            entries[h % RCB_LOG_QUEUE_SIZE] = { code, numSuppressed[c], a, b };
+            head.store(h + 1, std::memory_order_release);
+
+            numInWindow[c]++;
+            numSuppressed[c] = 0;
+        }
+
+        /** Consumer side, returns false when empty */
+        bool pop(RcbLogEntry& entry)
+        {
+            const uint32_t t = tail.load(std::memory_order_relaxed);
+
+            if (t == head.load(std::memory_order_acquire))
+                return false;
+
+            entry = entries[t % RCB_LOG_QUEUE_SIZE];
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Entries lost to a full queue, since the start */
+        uint32_t getNumDropped() const { return numDropped.load(std::memory_order_relaxed); }
+
+        /** Only call while neither side is running */
+        void reset()
+        {
+            head.store(0, std::memory_order_relaxed);
+            tail.store(0, std::memory_order_relaxed);
+            numDropped.store(0, std::memory_order_relaxed);
+
+            for (int c = 0; c < (int)RcbLogCode::NUM_CODES; c++)
+            {
+                windowStartMs[c] = 0;
+                numInWindow[c] = 0;
+                numSuppressed[c] = 0;
+            }
+        }
+
+    private:
+        RcbLogEntry entries[RCB_LOG_QUEUE_SIZE];
+        std::atomic<uint32_t> head { 0 };
+        std::atomic<uint32_t> tail { 0 };
+        std::atomic<uint32_t> numDropped { 0 };
+
+        // rate limit, producer only
+        int64_t windowStartMs[(int)RcbLogCode::NUM_CODES] = {};
+        uint32_t numInWindow[(int)RcbLogCode::NUM_CODES] = {};
+        uint32_t numSuppressed[(int)RcbLogCode::NUM_CODES] = {};
+    };
+}
+
+#endif
@@ -0,0 +1,54 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBPACKETH__
+#define __RCBPACKETH__
+
+#include <cstdint>
+
+// RCB UDP packet layout, in 16-bit words:
+//   [0]        start of data, low byte is the magic number 0xc5
+//   [4], [5]   sequence number, low word first
+//   [16]       aux mask (low byte) and aux phase (high byte)
+//   [18]       battery voltage
+//   [19]       state of digital inputs
+//   [20...]    num_samp frames of (num_channels + 2) samples: 2 aux slots, then the amplifier channels
+const uint8_t RCB_MAGIC_NUM = 0xc5;
+const int RCB_HEADER_WORDS = 20;
+const int RCB_FRAME_AUX_WORDS = 2;
+
+// Channel counts the RCB can stream and the number of frames per packet for each.
+// Same order as the editor channel comboBox.
+const int RCB_NUM_PACKET_FORMATS = 8;
+const int RCB_CHANNEL_COUNTS[RCB_NUM_PACKET_FORMATS] = { 32, 28, 24, 20, 16, 12, 8, 4 };
+const int RCB_SAMPLES_PER_PACKET[RCB_NUM_PACKET_FORMATS] = { 21, 23, 27, 32, 39, 51, 71, 119 };
+const int RCB_MAX_SAMPLES_PER_PACKET = 119;
+
+/** Number of 16-bit words in one frame, aux slots included */
+inline int rcbFrameWords(int numChannels) { return numChannels + RCB_FRAME_AUX_WORDS; }
+
+/** Size in bytes of a packet carrying numSamples frames */
+inline int rcbPacketBytes(int numChannels, int numSamples) { return (RCB_HEADER_WORDS + rcbFrameWords(numChannels) * numSamples) * 2; }
+
+#endif
@@ -0,0 +1,149 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBPACKETRINGH__
+#define __RCBPACKETRINGH__
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Largest RCB UDP packet is 40 + ((32 + 2) * 21) * 2 = 1468 bytes. Slots are sized a bit larger
+// so an oversized datagram is truncated instead of overrunning the next slot.
+const int RCB_MAX_PACKET_BYTES = 1504;
+
+// Number of packet slots between the socket reader thread and the DataThread. ~2 sec at 1000 packets/sec
+const int PACKET_RING_SIZE = 2048;
+
+// Max number of packets moved through the ring at once, by one recvmmsg() or one DataBuffer push
+const int RECV_BATCH_SIZE = 32;
+
+namespace RcbWifiNode
+{
+    /** One received UDP datagram */
+    struct RcbPacketSlot
+    {
+        int64_t rxTicks = 0;    // host receive time, Time::getHighResolutionTicks()
+        int32_t length = 0;     // number of bytes received
+        uint16_t data[RCB_MAX_PACKET_BYTES / 2];
+    };
+
+    /**
+        Single-producer / single-consumer lock-free ring of fixed-size packet slots.
+
+        The socket reader thread writes received datagrams straight into free slots and
+        publishes them; the DataThread reads ready slots in order and releases them.
+        Slots are handed out as contiguous runs so they can be filled by one recvmmsg().
+    */
+    class RcbPacketRing
+    {
+    public:
+        /** Capacity is rounded up to a power of two */
+        RcbPacketRing(int capacity)
+        {
+            int size = 1;
+            while (size < capacity)
+                size <<= 1;
+
+            slots.resize(size);
+            mask = uint32_t(size - 1);
+        }
+
+        int getCapacity() const { return int(slots.size()); }
+
+        /** Empties the ring and clears the statistics. Only call when both threads are stopped. */
+        void reset()
+        {
+            head.store(0, std::memory_order_relaxed);
+            tail.store(0, std::memory_order_relaxed);
+            highWaterMark.store(0, std::memory_order_relaxed);
+            overflowCount.store(0, std::memory_order_relaxed);
+        }
+
+        // ---- producer side ----
+
+        /** Returns up to maxSlots contiguous free slots starting at *first */
+        int getFreeSlots(RcbPacketSlot** first, int maxSlots)
+        {
+            uint32_t h = head.load(std::memory_order_relaxed);
+            uint32_t t = tail.load(std::memory_order_acquire);
+            uint32_t numFree = uint32_t(slots.size()) - (h - t);
+            uint32_t toEnd = uint32_t(slots.size()) - (h & mask);
+
+            *first = &slots[h & mask];
+            return int(std::min(std::min(numFree, toEnd), uint32_t(maxSlots)));
+        }
+
+        /** Makes the next n slots returned by getFreeSlots() visible to the consumer */
+        void publish(int n)
+        {
+            uint32_t h = head.load(std::memory_order_relaxed) + uint32_t(n);
+            head.store(h, std::memory_order_release);
+
+            uint32_t used = h - tail.load(std::memory_order_relaxed);
+            if (used > highWaterMark.load(std::memory_order_relaxed))
+                highWaterMark.store(used, std::memory_order_relaxed);
+        }
+
+        /** Counts packets that were dropped because the ring was full */
+        void addOverflow(int n) { overflowCount.fetch_add(uint32_t(n), std::memory_order_relaxed); }
+
+        // ---- consumer side ----
+
+        /** Returns up to maxSlots contiguous ready slots starting at *first */
+        int getReadySlots(const RcbPacketSlot** first, int maxSlots) const
+        {
+            uint32_t t = tail.load(std::memory_order_relaxed);
+            uint32_t h = head.load(std::memory_order_acquire);
+            uint32_t toEnd = uint32_t(slots.size()) - (t & mask);
+
+            *first = &slots[t & mask];
+            return int(std::min(std::min(h - t, toEnd), uint32_t(maxSlots)));
+        }
+
+        /** Returns the next n ready slots to the producer */
+        void release(int n)
+        {
+            tail.store(tail.load(std::memory_order_relaxed) + uint32_t(n), std::memory_order_release);
+        }
+
+        // ---- statistics, safe to read from any thread ----
+
+        int getNumReady() const { return int(head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire)); }
+        int getHighWaterMark() const { return int(highWaterMark.load(std::memory_order_relaxed)); }
+        uint32_t getOverflowCount() const { return overflowCount.load(std::memory_order_relaxed); }
+
+    private:
+        std::vector<RcbPacketSlot> slots;
+        uint32_t mask = 0;
+
+        alignas(64) std::atomic<uint32_t> head{ 0 };   // written by producer
+        alignas(64) std::atomic<uint32_t> tail{ 0 };   // written by consumer
+        alignas(64) std::atomic<uint32_t> highWaterMark{ 0 };
+        std::atomic<uint32_t> overflowCount{ 0 };
+    };
+}
+
+#endif
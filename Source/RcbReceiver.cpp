@@ -0,0 +1,317 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <Windows.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <cerrno>
+#endif
+
+#if JUCE_LINUX
+#include <linux/sock_diag.h>
+#endif
+
+#include "RcbReceiver.h"
+
+using namespace RcbWifiNode;
+
+RcbReceiver::RcbReceiver() : Thread("RCB Receiver")
+{
+#if JUCE_LINUX
+	memset(recvMsgs, 0, sizeof(recvMsgs));
+	for (int p = 0; p < RECV_BATCH_SIZE; p++)
+	{
+		recvIovecs[p].iov_len = RCB_MAX_PACKET_BYTES;
+		recvMsgs[p].msg_hdr.msg_iov = &recvIovecs[p];
+		recvMsgs[p].msg_hdr.msg_iovlen = 1;
+	}
+#endif
+}
+
+RcbReceiver::~RcbReceiver()
+{
+	stopThread(1000);
+}
+
+void RcbReceiver::addSource(DatagramSocket* socket, int port, RcbPacketRing* ring, RcbHistogram* socketQueueBytes)
+{
+#if JUCE_LINUX
+	// kernel receive times, so the time a packet waited for this thread to wake up is not hidden
+	int on = 1;
+	setsockopt(socket->getRawSocketHandle(), SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+#endif
+
+	sources.add({ socket, (uint16_t)port, ring, socketQueueBytes });
+	sourceReady.add(false);
+
+	struct pollfd fd = {};
+	fd.fd = socket->getRawSocketHandle();
+	fd.events = POLLIN;
+	pollFds.push_back(fd);
+}
+
+String RcbReceiver::getSchedulingInfo() const
+{
+	const ScopedLock sl(schedulingLock);
+	return schedulingInfo;
+}
+
+void RcbReceiver::run()
+{
+	// run ahead of the DataThread, GUI and recording threads. best effort, may need privileges
+	String info = applyThreadScheduling(priority, RCB_FIFO_PRIORITY_RECEIVER, cpu);
+	LOGC("[dspw] RCB Receiver thread: ", info);
+
+	{
+		const ScopedLock sl(schedulingLock);
+		schedulingInfo = info;
+	}
+
+	RcbSpinWait spin;
+
+	while (!threadShouldExit())
+	{
+		int numReady;
+
+		if (lowLatency)
+		{
+			// busy poll, every socket is read without waiting
+			for (int s = 0; s < sources.size(); s++)
+				sourceReady.set(s, true);
+
+			numReady = sources.size();
+		}
+		else
+		{
+			// wait with a timeout so the thread can still see threadShouldExit() when the RCBs stop streaming
+			numReady = waitForSources(100);
+		}
+
+		if (numReady < 0)
+		{
+			LOGD("[dspw] RCB Receiver socket poll failed");
+			break;
+		}
+
+		bool published = false;
+		bool failed = false;
+
+		for (int s = 0; s < sources.size() && numReady > 0; s++)
+		{
+			if (!sourceReady[s])
+				continue;
+
+			int numPackets = readSource(sources.getReference(s));
+
+			if (numPackets < 0)
+				failed = true;
+			else if (numPackets > 0)
+				published = true;
+		}
+
+		if (published)
+			dataReady.signal();
+
+		if (lowLatency)
+		{
+			if (published)
+				spin.reset();
+			else
+				spin.pause();
+		}
+
+		if (failed)
+		{
+			LOGD("[dspw] RCB Receiver socket read failed");
+			break;
+		}
+	}
+
+	// wake the DataThread in case it is waiting on us
+	dataReady.signal();
+}
+
+int RcbReceiver::waitForSources(int timeoutMs)
+{
+	// at most a handful of RCBs per host, so poll() on all sockets is as cheap as epoll here
+	struct pollfd* fds = pollFds.data();
+	int numFds = (int)pollFds.size();
+
+	for (int s = 0; s < numFds; s++)
+		fds[s].revents = 0;
+
+#ifdef _WIN32
+	int rc = WSAPoll(fds, (ULONG)numFds, timeoutMs);
+#else
+	int rc = poll(fds, (nfds_t)numFds, timeoutMs);
+
+	if (rc < 0 && errno == EINTR)
+		return 0;
+#endif
+
+	for (int s = 0; s < numFds; s++)
+	{
+		if (fds[s].revents & (POLLERR | POLLNVAL))
+			return -1;
+
+		sourceReady.set(s, (fds[s].revents & POLLIN) != 0);
+	}
+
+	return rc;
+}
+
+int64 RcbReceiver::getSocketQueueBytes(DatagramSocket* socket)
+{
+#if JUCE_LINUX && defined(SO_MEMINFO)
+	// FIONREAD on a UDP socket only gives the next datagram here, the receive memory counts the whole queue
+	uint32_t memInfo[SK_MEMINFO_VARS];
+	socklen_t length = sizeof(memInfo);
+
+	if (getsockopt(socket->getRawSocketHandle(), SOL_SOCKET, SO_MEMINFO, memInfo, &length) != 0)
+		return -1;
+
+	return memInfo[SK_MEMINFO_RMEM_ALLOC];
+#elif defined(_WIN32)
+	u_long numBytes = 0;
+	return ioctlsocket(socket->getRawSocketHandle(), FIONREAD, &numBytes) == 0 ? (int64)numBytes : -1;
+#else
+	// the whole receive buffer on macOS, the next datagram on Linux kernels without SO_MEMINFO
+	int numBytes = 0;
+	return ioctl(socket->getRawSocketHandle(), FIONREAD, &numBytes) == 0 ? (int64)numBytes : -1;
+#endif
+}
+
+int RcbReceiver::readSource(Source& source)
+{
+	// the backlog the kernel built up while this thread was away, before it is drained
+	int64 queueBytes = source.socketQueueBytes != nullptr ? getSocketQueueBytes(source.socket) : -1;
+
+	RcbPacketSlot* slots;
+	int numFree = source.ring->getFreeSlots(&slots, RECV_BATCH_SIZE);
+
+	if (numFree == 0)
+	{
+		// DataThread is not keeping up. keep draining the socket so the loss is counted here
+		int numDropped = receivePackets(source.socket, &overflowSlot, 1);
+
+		if (numDropped > 0)
+		{
+			source.ring->addOverflow(numDropped);
+
+			if (capture != nullptr)
+				capture->write(source.port, overflowSlot);
+		}
+
+		return numDropped < 0 ? -1 : 0;
+	}
+
+	int numPackets = receivePackets(source.socket, slots, numFree);
+
+	if (numPackets > 0)
+	{
+		// journal before publishing, the DataThread may reuse the slots right after
+		if (capture != nullptr)
+		{
+			for (int p = 0; p < numPackets; p++)
+				capture->write(source.port, slots[p]);
+		}
+
+		source.ring->publish(numPackets);
+
+		// only wake-ups with packets, a busy polling loop would otherwise fill bucket 0
+		if (queueBytes >= 0)
+			source.socketQueueBytes->add((uint64)queueBytes);
+	}
+
+	return numPackets;
+}
+
+int RcbReceiver::receivePackets(DatagramSocket* socket, RcbPacketSlot* slots, int count)
+{
+#if JUCE_LINUX
+	// drain everything the kernel has queued, straight into the ring slots, in one syscall
+	for (int p = 0; p < count; p++)
+	{
+		recvIovecs[p].iov_base = slots[p].data;
+		recvMsgs[p].msg_hdr.msg_control = recvControl[p];
+		recvMsgs[p].msg_hdr.msg_controllen = sizeof(recvControl[p]);
+	}
+
+	int rc = recvmmsg(socket->getRawSocketHandle(), recvMsgs, count, MSG_DONTWAIT, nullptr);
+
+	if (rc == -1)
+		return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+
+	int64 now = Time::getHighResolutionTicks();
+	const double ticksPerNs = double(Time::getHighResolutionTicksPerSecond()) * 1e-9;
+
+	// kernel timestamps are wall clock time, move them to the high resolution clock by their age
+	struct timespec wallNow;
+	clock_gettime(CLOCK_REALTIME, &wallNow);
+
+	for (int p = 0; p < rc; p++)
+	{
+		slots[p].rxTicks = now;
+		slots[p].length = (int32_t)recvMsgs[p].msg_len;
+
+		for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&recvMsgs[p].msg_hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&recvMsgs[p].msg_hdr, cmsg))
+		{
+			if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS)
+			{
+				struct timespec stamp;
+				memcpy(&stamp, CMSG_DATA(cmsg), sizeof(stamp));
+
+				int64 ageNs = (int64)(wallNow.tv_sec - stamp.tv_sec) * 1000000000 + (wallNow.tv_nsec - stamp.tv_nsec);
+				if (ageNs > 0 && ageNs < 1000000000)
+					slots[p].rxTicks = now - (int64)(ageNs * ticksPerNs);
+			}
+		}
+	}
+
+	return rc;
+#else
+	int numPackets = 0;
+
+	while (numPackets < count)
+	{
+		int rc = socket->read(slots[numPackets].data, RCB_MAX_PACKET_BYTES, false);
+
+		if (rc < 0)
+			return numPackets > 0 ? numPackets : -1;
+
+		if (rc == 0)
+			break;
+
+		slots[numPackets].rxTicks = Time::getHighResolutionTicks();
+		slots[numPackets].length = rc;
+		numPackets++;
+	}
+
+	return numPackets;
+#endif
+}
@@ -0,0 +1,137 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBRECEIVERH__
+#define __RCBRECEIVERH__
+
+#include <DataThreadHeaders.h>
+
+#include "RcbCapture.h"
+#include "RcbPacketRing.h"
+#include "RcbScheduling.h"
+#include "RcbTelemetry.h"
+
+#if JUCE_LINUX
+#include <sys/socket.h>
+#include <cerrno>
+#endif
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+#include <vector>
+
+namespace RcbWifiNode
+{
+    /**
+        Socket reader thread.  Only pulls datagrams off the UDP sockets into the packet rings,
+        so back-pressure on the DataThread does not turn into kernel socket buffer overflow.
+        All sockets are serviced from one poll() loop, however many RCB devices are streaming.
+    */
+    class RcbReceiver : public Thread
+    {
+    public:
+        /** Constructor */
+        RcbReceiver();
+
+        /** Destructor */
+        ~RcbReceiver();
+
+        /**
+            Adds a socket to service, bound to port, the ring its packets go to and the histogram of
+            its kernel receive queue, nullptr for none.  Call before startThread()
+        */
+        void addSource(DatagramSocket* socket, int port, RcbPacketRing* ring, RcbHistogram* socketQueueBytes);
+
+        /** Journals every received datagram, including those dropped on a full ring. Call before startThread() */
+        void setCapture(RcbCaptureWriter* capture_) { capture = capture_; }
+
+        /** Priority and CPU the thread sets for itself when it starts, cpu -1 leaves it free. Call before startThread() */
+        void setScheduling(RcbThreadPriority priority_, int cpu_) { priority = priority_; cpu = cpu_; }
+
+        /** Priority and CPU the thread got, empty until it has started */
+        String getSchedulingInfo() const;
+
+        /** Polls the sockets without waiting, for the lowest receive latency at the cost of a busy core. Call before startThread() */
+        void setLowLatency(bool lowLatency_) { lowLatency = lowLatency_; }
+
+        /** Thread loop */
+        void run() override;
+
+        /** Signalled whenever new packets are published to any ring */
+        WaitableEvent dataReady;
+
+    private:
+        struct Source
+        {
+            DatagramSocket* socket;
+            uint16_t port;
+            RcbPacketRing* ring;
+            RcbHistogram* socketQueueBytes;
+        };
+
+        /** Waits until at least one socket is readable. Returns number of readable sockets, 0 on timeout, -1 on error */
+        int waitForSources(int timeoutMs);
+
+        /** Reads pending packets of one source into its ring. Returns number of packets, -1 on error */
+        int readSource(Source& source);
+
+        /** Bytes queued in the kernel receive buffer of a socket, -1 if the platform cannot tell */
+        static int64 getSocketQueueBytes(DatagramSocket* socket);
+
+        /** Reads up to count packets into slots without blocking. Returns number of packets, -1 on error */
+        int receivePackets(DatagramSocket* socket, RcbPacketSlot* slots, int count);
+
+        Array<Source> sources;
+        Array<bool> sourceReady;
+
+        /** poll() descriptors, one per source, filled in by addSource() */
+        std::vector<struct pollfd> pollFds;
+
+        /** Packet is read here and discarded when a ring is full */
+        RcbPacketSlot overflowSlot;
+
+        RcbCaptureWriter* capture = nullptr;
+
+        RcbThreadPriority priority = RcbThreadPriority::HIGH;
+        int cpu = -1;
+        bool lowLatency = false;
+
+        CriticalSection schedulingLock;
+        String schedulingInfo;
+
+#if JUCE_LINUX
+        /** recvmmsg() descriptors */
+        struct mmsghdr recvMsgs[RECV_BATCH_SIZE];
+        struct iovec recvIovecs[RECV_BATCH_SIZE];
+
+        /** SO_TIMESTAMPNS kernel receive times */
+        char recvControl[RECV_BATCH_SIZE][CMSG_SPACE(sizeof(struct timespec))];
+#endif
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RcbReceiver);
+    };
+}
+#endif
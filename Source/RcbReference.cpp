@@ -0,0 +1,97 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "RcbReference.h"
+
+#include <algorithm>
+
+using namespace RcbWifiNode;
+
+void RcbReference::setup(RcbReferenceMode mode_, uint32_t groupMask, int numChans)
+{
+	mode = mode_;
+	numChannels = std::min(std::max(numChans, 0), RCB_FILTER_MAX_CHANNELS);
+	groupSize = 0;
+
+	for (int c = 0; c < RCB_FILTER_MAX_CHANNELS; c++)
+		weights[c] = 0.0f;
+
+	for (int c = 0; c < numChannels; c++)
+	{
+		if (groupMask == 0 || (groupMask >> c) & 1)
+			groupChannels[groupSize++] = (int8_t)c;
+	}
+
+	for (int g = 0; g < groupSize; g++)
+		weights[groupChannels[g]] = 1.0f / float(groupSize);
+}
+
+void RcbReference::process(float* frames, int stride, int numFrames) const
+{
+	if (!isActive())
+		return;
+
+	const int n = numChannels;
+
+	for (int f = 0; f < numFrames; f++)
+	{
+		float* row = frames + (size_t)f * stride;
+		float reference = 0.0f;
+
+		if (mode == RcbReferenceMode::CAR)
+		{
+			// four independent partial sums, so the compiler can keep them in one SIMD register.
+			// every RCB channel count is a multiple of 4
+			float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+			for (int c = 0; c + 4 <= n; c += 4)
+			{
+				for (int j = 0; j < 4; j++)
+					sum[j] += weights[c + j] * row[c + j];
+			}
+
+			for (int c = n & ~3; c < n; c++)
+				sum[0] += weights[c] * row[c];
+
+			reference = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+		}
+		else
+		{
+			float group[RCB_FILTER_MAX_CHANNELS];
+			for (int g = 0; g < groupSize; g++)
+				group[g] = row[groupChannels[g]];
+
+			// upper middle, and for an even group the mean with the largest value below it
+			const int middle = groupSize / 2;
+			std::nth_element(group, group + middle, group + groupSize);
+			reference = group[middle];
+
+			if (groupSize % 2 == 0)
+				reference = 0.5f * (reference + *std::max_element(group, group + middle));
+		}
+
+		for (int c = 0; c < n; c++)
+			row[c] -= reference;
+	}
+}
@@ -0,0 +1,71 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBREFERENCEH__
+#define __RCBREFERENCEH__
+
+#include <cstdint>
+
+#include "RcbFilterBank.h"
+
+namespace RcbWifiNode
+{
+    /** How the common reference of each sample is taken */
+    enum class RcbReferenceMode
+    {
+        OFF,
+        CAR,        // mean of the reference group
+        MEDIAN      // median of the reference group, not pulled by one bad channel
+    };
+
+    /**
+        Re-references every amplifier channel of a sample to the mean or median of a group of
+        channels, removing the common-mode artifacts wireless headstages pick up.
+
+        Runs on the rows of a freshly decoded packet while they are still in cache.  The mean is
+        a weighted sum over the row, with weight 0 outside the group, so it vectorizes whatever
+        the group is.
+    */
+    class RcbReference
+    {
+    public:
+        /** groupMask bit c puts channel c in the reference group, 0 means all channels */
+        void setup(RcbReferenceMode mode, uint32_t groupMask, int numChannels);
+
+        bool isActive() const { return mode != RcbReferenceMode::OFF && groupSize > 0; }
+
+        /** Re-references the first numChannels floats of numFrames rows, rows are stride floats apart */
+        void process(float* frames, int stride, int numFrames) const;
+
+    private:
+        RcbReferenceMode mode = RcbReferenceMode::OFF;
+        int numChannels = 0;
+        int groupSize = 0;
+
+        float weights[RCB_FILTER_MAX_CHANNELS] = {};      // 1 / groupSize in the group, 0 outside
+        int8_t groupChannels[RCB_FILTER_MAX_CHANNELS] = {};
+    };
+}
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+#include "RcbReplay.h"
+
+using namespace RcbWifiNode;
+
+RcbReplay::RcbReplay(const File& captureFile_, bool realTime_) :
+	Thread("RCB Replay"),
+	captureFile(captureFile_),
+	realTime(realTime_)
+{
+}
+
+RcbReplay::~RcbReplay()
+{
+	stopThread(1000);
+}
+
+bool RcbReplay::open()
+{
+	return reader.open(captureFile);
+}
+
+void RcbReplay::addDevice(int port, RcbPacketRing* ring)
+{
+	devices.add({ port, ring });
+}
+
+void RcbReplay::run()
+{
+	const RcbCaptureHeader& header = reader.getHeader();
+	const double tickScale = double(Time::getHighResolutionTicksPerSecond()) / double(jmax(int64(1), (int64)header.ticksPerSecond));
+	const int64 startTicks = Time::getHighResolutionTicks();
+
+	RcbCaptureRecord record;
+	const uint8_t* data;
+	int64 firstRxTicks = -1;
+	int numUnsignalled = 0;
+
+	while (!threadShouldExit() && reader.next(record, data))
+	{
+		RcbPacketRing* ring = nullptr;
+
+		for (auto& device : devices)
+		{
+			if (device.port == record.port)
+				ring = device.ring;
+		}
+
+		if (ring == nullptr)
+		{
+			numSkipped++;
+			continue;
+		}
+
+		if (firstRxTicks < 0)
+			firstRxTicks = record.rxTicks;
+
+		const int64 rxTicks = startTicks + int64(double(record.rxTicks - firstRxTicks) * tickScale);
+
+		if (realTime)
+		{
+			// let the DataThread have what is out so far, then wait for this packet's time
+			if (numUnsignalled > 0 && rxTicks > Time::getHighResolutionTicks())
+			{
+				dataReady.signal();
+				numUnsignalled = 0;
+			}
+
+			while (!threadShouldExit())
+			{
+				double aheadMs = Time::highResolutionTicksToSeconds(rxTicks - Time::getHighResolutionTicks()) * 1000.0;
+
+				if (aheadMs <= 0)
+					break;
+
+				Thread::sleep(jlimit(1, 100, int(aheadMs)));
+			}
+		}
+
+		// never drop, wait for the DataThread to free a slot
+		RcbPacketSlot* slot;
+
+		while (ring->getFreeSlots(&slot, 1) == 0)
+		{
+			dataReady.signal();
+			numUnsignalled = 0;
+
+			if (threadShouldExit())
+				return;
+
+			Thread::sleep(1);
+		}
+
+		const int length = jmin((int)record.length, RCB_MAX_PACKET_BYTES);
+		memcpy(slot->data, data, (size_t)length);
+		slot->length = length;
+		slot->rxTicks = rxTicks;
+		ring->publish(1);
+
+		numPackets++;
+
+		if (++numUnsignalled >= RECV_BATCH_SIZE)
+		{
+			dataReady.signal();
+			numUnsignalled = 0;
+		}
+	}
+
+	LOGC("[dspw] RCB replay finished, ", String(numPackets.load()), " packets");
+
+	// wake the DataThread for the last packets
+	dataReady.signal();
+}
@@ -0,0 +1,88 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+#ifndef __RCBREPLAYH__
+#define __RCBREPLAYH__
+
+#include <DataThreadHeaders.h>
+
+#include "RcbCapture.h"
+#include "RcbPacketRing.h"
+
+namespace RcbWifiNode
+{
+    /**
+        Stands in for RcbReceiver: feeds the datagrams of a capture file into the packet
+        rings, so they go through the same decode path without any socket.  Receive times
+        are moved to now, keeping their spacing.  In real time mode packets are released
+        at their original pace, otherwise as fast as the DataThread takes them.
+    */
+    class RcbReplay : public Thread
+    {
+    public:
+        /** Constructor */
+        RcbReplay(const File& captureFile, bool realTime);
+
+        /** Destructor */
+        ~RcbReplay();
+
+        /** Opens the capture file, false if it is missing or not a capture */
+        bool open();
+
+        /** Packets that arrived on port go to ring. Call before startThread() */
+        void addDevice(int port, RcbPacketRing* ring);
+
+        /** Thread loop */
+        void run() override;
+
+        /** Signalled whenever new packets are published to any ring */
+        WaitableEvent dataReady;
+
+        /** Devices recorded in the capture */
+        const RcbCaptureHeader& getHeader() const { return reader.getHeader(); }
+
+        int64 getNumPackets() const { return numPackets; }
+        int64 getNumSkipped() const { return numSkipped; }
+
+    private:
+        struct Device
+        {
+            int port;
+            RcbPacketRing* ring;
+        };
+
+        File captureFile;
+        bool realTime;
+
+        RcbCaptureReader reader;
+        Array<Device> devices;
+
+        std::atomic<int64> numPackets{ 0 };
+        std::atomic<int64> numSkipped{ 0 };  // records of ports no device listens on
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RcbReplay);
+    };
+}
+#endif
@@ -0,0 +1,174 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sys/socket.h>
+#endif
+
+#include "RcbScheduling.h"
+
+#if JUCE_LINUX
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace RcbWifiNode;
+
+String RcbWifiNode::applyThreadScheduling(RcbThreadPriority priority, int fifoPriority, int cpu)
+{
+	String info;
+
+#ifdef _WIN32
+	if (priority != RcbThreadPriority::NORMAL)
+	{
+		int winPriority = priority == RcbThreadPriority::REALTIME ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST;
+
+		if (!SetThreadPriority(GetCurrentThread(), winPriority) && priority == RcbThreadPriority::REALTIME)
+			SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+	}
+
+	int achieved = GetThreadPriority(GetCurrentThread());
+	info << (achieved == THREAD_PRIORITY_TIME_CRITICAL ? "time critical" : achieved == THREAD_PRIORITY_HIGHEST ? "highest" : "normal");
+
+	if (cpu >= 0)
+		info << (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0 ? ", CPU " + String(cpu) : ", CPU " + String(cpu) + " refused");
+#else
+	bool realtime = false;
+
+	if (priority == RcbThreadPriority::REALTIME)
+	{
+		// needs CAP_SYS_NICE or an rtprio limit on Linux, e.g. "@audio - rtprio 95" in /etc/security/limits.conf
+		sched_param param;
+		param.sched_priority = jlimit(sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO), fifoPriority);
+		realtime = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+	}
+
+#if JUCE_LINUX
+	// nice only applies to one thread on Linux
+	if (priority != RcbThreadPriority::NORMAL && !realtime)
+		setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), -10);
+#endif
+
+	int policy = SCHED_OTHER;
+	sched_param param;
+	pthread_getschedparam(pthread_self(), &policy, &param);
+
+	if (policy == SCHED_FIFO)
+		info << "SCHED_FIFO " << param.sched_priority;
+	else
+	{
+#if JUCE_LINUX
+		info << "nice " << getpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid));
+#else
+		info << "normal";
+#endif
+	}
+
+	if (priority == RcbThreadPriority::REALTIME && !realtime)
+		info << " (SCHED_FIFO not permitted)";
+
+	if (cpu >= 0)
+	{
+#if JUCE_LINUX
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu, &cpus);
+
+		if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0)
+			info << ", CPU " << cpu;
+		else
+			info << ", CPU " << cpu << " refused";
+#else
+		// macOS only takes affinity hints, there is no pinning
+		info << ", CPU pinning not supported";
+#endif
+	}
+#endif
+
+	return info;
+}
+
+int RcbWifiNode::setBusyPoll(DatagramSocket* socket, int microseconds)
+{
+#if JUCE_LINUX && defined(SO_BUSY_POLL)
+	if (socket == nullptr || socket->getRawSocketHandle() < 0)
+		return 0;
+
+	auto fd = socket->getRawSocketHandle();
+	setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &microseconds, sizeof(microseconds));
+
+	int granted = 0;
+	socklen_t length = sizeof(granted);
+
+	if (getsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &granted, &length) != 0)
+		return 0;
+
+	return granted;
+#else
+	ignoreUnused(socket, microseconds);
+	return 0;
+#endif
+}
+
+int RcbWifiNode::setReceiveBufferSize(DatagramSocket* socket, int numBytes)
+{
+	if (socket == nullptr || socket->getRawSocketHandle() < 0)
+		return 0;
+
+	auto fd = socket->getRawSocketHandle();
+
+	if (numBytes > 0)
+	{
+#if JUCE_LINUX
+		// SO_RCVBUFFORCE goes past net.core.rmem_max with CAP_NET_ADMIN, otherwise the request is capped to it
+		if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &numBytes, sizeof(numBytes)) != 0)
+			setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &numBytes, sizeof(numBytes));
+#else
+		setsockopt(fd, SOL_SOCKET, SO_RCVBUF, (const char*)&numBytes, sizeof(numBytes));
+#endif
+	}
+
+	int granted = 0;
+#ifdef _WIN32
+	int length = sizeof(granted);
+#else
+	socklen_t length = sizeof(granted);
+#endif
+
+	if (getsockopt(fd, SOL_SOCKET, SO_RCVBUF, (char*)&granted, &length) != 0)
+		return 0;
+
+#if JUCE_LINUX
+	// Linux reports twice the size asked for, the extra is its bookkeeping
+	granted /= 2;
+#endif
+
+	return granted;
+}
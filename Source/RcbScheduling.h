@@ -0,0 +1,109 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBSCHEDULINGH__
+#define __RCBSCHEDULINGH__
+
+#include <DataThreadHeaders.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+// SCHED_FIFO priorities of the socket reader thread and the DataThread, reader first so it can always drain the sockets
+const int RCB_FIFO_PRIORITY_RECEIVER = 70;
+const int RCB_FIFO_PRIORITY_DATATHREAD = 60;
+
+// Busy poll time asked for on the RCB sockets in low latency mode, microseconds
+const int RCB_BUSY_POLL_US = 50;
+
+// Socket receive buffer unless set with the RCVBUF config message, ~3 sec of packets at 32 channels
+const int RCB_DEFAULT_RCVBUF_KB = 4096;
+
+namespace RcbWifiNode
+{
+    /** Scheduling of the threads on the streaming path */
+    enum class RcbThreadPriority
+    {
+        NORMAL,     // left as created
+        HIGH,       // raised within the normal scheduler: nice -10, THREAD_PRIORITY_HIGHEST
+        REALTIME    // SCHED_FIFO, THREAD_PRIORITY_TIME_CRITICAL. falls back to HIGH where not permitted
+    };
+
+    /**
+        Sets the priority and CPU of the calling thread, fifoPriority is used for REALTIME, cpu -1
+        leaves it free to move.  Best effort, returns what the OS actually gave it, e.g. "SCHED_FIFO 70, CPU 2".
+    */
+    String applyThreadScheduling(RcbThreadPriority priority, int fifoPriority, int cpu);
+
+    /**
+        Sets SO_BUSY_POLL, so a read with no data waiting polls the network card for up to
+        microseconds instead of returning.  Linux only, raising it needs CAP_NET_ADMIN.
+        Returns the time the OS granted, 0 if none.
+    */
+    int setBusyPoll(DatagramSocket* socket, int microseconds);
+
+    /**
+        Adaptive wait for busy-polling loops.  Spins on the core while the next packet is due,
+        then yields it to other threads, and once nothing has arrived for a long time, e.g. the
+        RCBs stopped streaming, sleeps so an idle plugin does not keep a core busy.
+    */
+    class RcbSpinWait
+    {
+    public:
+        /** Call when work arrived */
+        void reset() { numIdle = 0; }
+
+        /** Call when a poll found nothing */
+        void pause()
+        {
+            if (numIdle < SPIN_POLLS)
+            {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+                _mm_pause();
+#elif defined(__aarch64__)
+                asm volatile("yield");
+#endif
+            }
+            else if (numIdle < YIELD_POLLS)
+                Thread::yield();
+            else
+                Thread::sleep(1);
+
+            numIdle = jmin(numIdle + 1, YIELD_POLLS);
+        }
+
+    private:
+        // tens of microseconds of spinning, then about a second of yielding
+        static const int SPIN_POLLS = 4000;
+        static const int YIELD_POLLS = 500000;
+
+        int numIdle = 0;
+    };
+
+    /** Asks for a socket receive buffer of numBytes, 0 leaves it as it is. Returns the size the OS granted, 0 if unknown */
+    int setReceiveBufferSize(DatagramSocket* socket, int numBytes);
+}
+
+#endif
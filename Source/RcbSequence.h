@@ -0,0 +1,252 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+#ifndef __RCBSEQUENCEH__
+#define __RCBSEQUENCEH__
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "RcbPacketRing.h"
+
+// Largest reorder window, in packets
+const int RCB_MAX_REORDER_PACKETS = 256;
+
+// A packet more than this many packets behind the expected one is taken as the RCB restarting its
+// sequence (re-init or reboot) rather than as a late packet.  Larger than any reorder window
+const uint32_t RCB_LATE_PACKETS = RCB_MAX_REORDER_PACKETS;
+
+/** True if sn going back from the expected seqNum means the RCB restarted its sequence, at 1 or after a large jump */
+inline bool rcbIsSequenceRestart(uint32_t sn, uint32_t expected)
+{
+    return expected != 0 && sn + 1 < expected && (sn == 1 || expected - sn > RCB_LATE_PACKETS);
+}
+
+// Reorder depth histogram buckets: depth 0 to 31, then 32 or more, then packets too late for the window
+const int RCB_REORDER_HIST_SIZE = 34;
+
+namespace RcbWifiNode
+{
+    /** Sequence number accounting of one RCB stream: packets received, lost and late */
+    class RcbSequenceCounter
+    {
+    public:
+        /** Starts over at seqNum with all counters cleared, 0 waits for the first packet */
+        void restart(uint32_t seqNum = 0)
+        {
+            nextSeqNum = seqNum;
+            hit = 0;
+            miss = 0;
+            delayed = 0;
+            restarts = 0;
+        }
+
+        /** True if seqNum is the RCB starting its sequence over rather than a late packet */
+        bool isRestart(uint32_t seqNum) const { return rcbIsSequenceRestart(seqNum, nextSeqNum); }
+
+        /** Takes the next packet as the first of a new sequence, keeping the counters */
+        void restartSequence()
+        {
+            nextSeqNum = 0;
+            restarts++;
+        }
+
+        /**
+            Counts one packet.  Returns the number of packets lost just before it, 0 if it was
+            next in sequence, or -1 if it is older than a packet already counted.  Check
+            isRestart() first, a restart would otherwise be counted as late.
+        */
+        int64_t count(uint32_t seqNum)
+        {
+            if (nextSeqNum == 0 || seqNum == nextSeqNum)
+            {
+                nextSeqNum = seqNum + 1;
+                hit++;
+                return 0;
+            }
+
+            if (seqNum < nextSeqNum)
+            {
+                delayed++;
+                return -1;
+            }
+
+            uint32_t lost = seqNum - nextSeqNum;
+            miss += lost;
+            nextSeqNum = seqNum + 1;
+            hit++;
+            return lost;
+        }
+
+        /** Continues the sequence after a late packet that was kept */
+        void resync(uint32_t seqNum) { nextSeqNum = seqNum + 1; }
+
+        uint32_t nextSeqNum = 0;
+        uint32_t hit = 0;
+        uint32_t miss = 0;
+        uint32_t delayed = 0;
+        uint32_t restarts = 0;
+    };
+
+    /**
+        Holds out of order packets for up to a window of packets and releases them in sequence.
+        A missing packet is given up on once the window is full, and a packet that arrives after
+        its place was released is dropped.
+    */
+    class RcbReorderWindow
+    {
+    public:
+        /** 0 turns reordering off. Forgets held packets */
+        void setSize(int numPackets)
+        {
+            size = std::min(std::max(numPackets, 0), RCB_MAX_REORDER_PACKETS);
+            heldSlots.resize(size);
+            heldSeq.assign(size, 0);
+            numHeld = 0;
+        }
+
+        int getSize() const { return size; }
+
+        /** Forgets held packets and clears the histogram */
+        void reset()
+        {
+            numHeld = 0;
+            next = 0;
+            maxSeq = 0;
+            std::fill(heldSeq.begin(), heldSeq.end(), 0);
+            std::fill(hist, hist + RCB_REORDER_HIST_SIZE, 0);
+        }
+
+        /** True if a packet sn would be dropped because its place was already released */
+        bool isTooLate(uint32_t sn) const { return next != 0 && sn < next && !rcbIsSequenceRestart(sn, next); }
+
+        /**
+            Puts packet sn through the window.  release(data, rxTicks) is called for each packet
+            now in sequence, oldest first, and returns false for a bad packet.  Returns false if
+            any released packet was bad.
+        */
+        template <typename Release>
+        bool push(const RcbPacketSlot& packetSlot, uint32_t sn, Release&& release)
+        {
+            const uint32_t window = (uint32_t)size;
+            bool ok = true;
+
+            // the RCB started its sequence over: release what is held from the old one, then start from sn
+            if (rcbIsSequenceRestart(sn, next))
+            {
+                while (numHeld > 0)
+                {
+                    uint32_t slot = next % window;
+                    if (heldSeq[slot] == next)
+                    {
+                        ok = release(heldSlots[slot].data, heldSlots[slot].rxTicks) && ok;
+                        heldSeq[slot] = 0;
+                        numHeld--;
+                    }
+                    next++;
+                }
+
+                next = 0;
+                maxSeq = 0;
+            }
+
+            if (next == 0)
+                next = sn;
+
+            if (sn < next)
+            {
+                // older than the window, its place in the timeline has already been released
+                hist[RCB_REORDER_HIST_SIZE - 1]++;
+                return true;
+            }
+
+            uint32_t depth = sn < maxSeq ? maxSeq - sn : 0;
+            hist[std::min(depth, (uint32_t)RCB_REORDER_HIST_SIZE - 2)]++;
+            maxSeq = std::max(maxSeq, sn);
+
+            // window ran out, give up on the oldest missing packets. the sequence counter sees them as lost
+            while (sn - next >= window)
+            {
+                if (numHeld == 0)
+                {
+                    next = sn - window + 1;
+                    break;
+                }
+
+                uint32_t slot = next % window;
+                if (heldSeq[slot] == next)
+                {
+                    ok = release(heldSlots[slot].data, heldSlots[slot].rxTicks) && ok;
+                    heldSeq[slot] = 0;
+                    numHeld--;
+                }
+                next++;
+            }
+
+            if (sn == next)
+            {
+                ok = release(packetSlot.data, packetSlot.rxTicks) && ok;
+                next++;
+            }
+            else
+            {
+                // a gap before it, hold it until the gap fills or the window runs out
+                uint32_t slot = sn % window;
+                if (heldSeq[slot] != sn)
+                    numHeld++;
+
+                heldSlots[slot] = packetSlot;
+                heldSeq[slot] = sn;
+            }
+
+            // release whatever is now in sequence
+            while (numHeld > 0 && heldSeq[next % window] == next)
+            {
+                uint32_t slot = next % window;
+                ok = release(heldSlots[slot].data, heldSlots[slot].rxTicks) && ok;
+                heldSeq[slot] = 0;
+                numHeld--;
+                next++;
+            }
+
+            return ok;
+        }
+
+        /** Packets by how far behind the newest one they arrived, the last bucket counts those too late for the window */
+        const uint32_t* getHistogram() const { return hist; }
+
+    private:
+        int size = 0;
+        int numHeld = 0;
+        uint32_t next = 0;      // next seqNum to release, 0 before the first packet
+        uint32_t maxSeq = 0;    // newest seqNum seen
+        std::vector<RcbPacketSlot> heldSlots;   // packets are held in slot seqNum % size
+        std::vector<uint32_t> heldSeq;          // seqNum in each slot, 0 if empty
+        uint32_t hist[RCB_REORDER_HIST_SIZE] = {};
+    };
+}
+
+#endif
@@ -0,0 +1,103 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "RcbSpikeDetector.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace RcbWifiNode;
+
+// noise estimate before the first samples, uV, and the floor it cannot drop below
+static const float NOISE_START = 10.0f;
+static const float NOISE_FLOOR = 0.1f;
+
+void RcbSpikeDetector::setup(const RcbSpikeSettings& settings_, double sampleRate, int numChans)
+{
+	settings = settings_;
+	settings.refractorySamples = std::min(std::max(settings.refractorySamples, 1), RCB_SPIKE_MAX_REFRACTORY);
+	numChannels = std::min(std::max(numChans, 0), RCB_FILTER_MAX_CHANNELS);
+
+	// relative step per sample, the estimate can move by a factor e in noiseSeconds
+	noiseStep = sampleRate > 0 ? float(1.0 / (std::max(settings.noiseSeconds, 0.01f) * sampleRate)) : 0.0f;
+	thresholdScale = -settings.thresholdK / 0.6745f;
+	numWarmup = int64_t(sampleRate * std::max(settings.noiseSeconds, 0.01f));
+
+	reset();
+}
+
+void RcbSpikeDetector::reset()
+{
+	for (int c = 0; c < RCB_FILTER_MAX_CHANNELS; c++)
+	{
+		noise[c] = NOISE_START;
+		previous[c] = 0.0f;
+		deadUntil[c] = 0;
+		counts[c].store(0, std::memory_order_relaxed);
+		thresholds[c].store(thresholdScale * NOISE_START, std::memory_order_relaxed);
+	}
+
+	row = 0;
+}
+
+void RcbSpikeDetector::process(const float* frames, int stride, int numFrames, unsigned long long* eventWords, int firstLine)
+{
+	if (!isActive())
+		return;
+
+	const int n = numChannels;
+
+	for (int f = 0; f < numFrames; f++, row++)
+	{
+		const float* x = frames + (size_t)f * stride;
+		uint64_t crossed = 0;
+
+		for (int c = 0; c < n; c++)
+		{
+			// median tracking: step up when |x| is above the estimate, down when below
+			const float magnitude = std::fabs(x[c]);
+			noise[c] = std::max(noise[c] * (magnitude > noise[c] ? 1.0f + noiseStep : 1.0f - noiseStep), NOISE_FLOOR);
+
+			const float threshold = thresholdScale * noise[c];
+			crossed |= uint64_t(x[c] < threshold && previous[c] >= threshold) << c;
+			previous[c] = x[c];
+		}
+
+		if (crossed != 0 && row >= numWarmup)
+		{
+			for (int c = 0; c < n; c++)
+			{
+				if (!((crossed >> c) & 1) || row < deadUntil[c])
+					continue;
+
+				eventWords[f] |= 1ULL << (firstLine + c);
+				counts[c].store(counts[c].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				deadUntil[c] = row + settings.refractorySamples;
+			}
+		}
+	}
+
+	for (int c = 0; c < n; c++)
+		thresholds[c].store(thresholdScale * noise[c], std::memory_order_relaxed);
+}
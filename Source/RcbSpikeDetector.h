@@ -0,0 +1,94 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBSPIKEDETECTORH__
+#define __RCBSPIKEDETECTORH__
+
+#include <atomic>
+#include <cstdint>
+
+#include "RcbFilterBank.h"
+
+// Longest refractory period, samples
+const int RCB_SPIKE_MAX_REFRACTORY = 64;
+
+namespace RcbWifiNode
+{
+    struct RcbSpikeSettings
+    {
+        bool enabled = false;
+        float thresholdK = 4.5f;    // threshold in noise standard deviations, estimated as median(|x|) / 0.6745
+        int refractorySamples = 24; // from the crossing on, the dead time before the channel can fire again
+        float noiseSeconds = 2.0f;  // time the noise estimate takes to follow a change
+    };
+
+    /**
+        Negative threshold crossing detector run on the samples on their way to the DataBuffer.
+
+        The threshold of each channel follows its noise: median(|x|) is tracked sample by sample
+        with a multiplicative step up or down, so it needs no history and runs across the channels
+        of a row in one loop.  A crossing sets the channel's bit in the row's event mask, then the
+        channel cannot fire again for refractorySamples.  No waveforms are kept: a DataThread can only
+        publish samples and TTL words.
+    */
+    class RcbSpikeDetector
+    {
+    public:
+        /** Allocates, only call when not streaming */
+        void setup(const RcbSpikeSettings& settings, double sampleRate, int numChannels);
+
+        /** Restarts the noise estimate and the spike counts */
+        void reset();
+
+        bool isActive() const { return settings.enabled && numChannels > 0; }
+
+        /**
+            Scans the first numChannels floats of numFrames rows, rows are stride floats apart.
+            Sets bit firstLine + channel of eventWords on each crossing sample.  The pointer types are those of JUCE int64/uint64.
+        */
+        void process(const float* frames, int stride, int numFrames, unsigned long long* eventWords, int firstLine);
+
+        /** Readable from any thread while streaming */
+        uint32_t getCount(int channel) const { return counts[channel].load(std::memory_order_relaxed); }
+        float getThreshold(int channel) const { return thresholds[channel].load(std::memory_order_relaxed); }
+
+    private:
+        RcbSpikeSettings settings;
+        int numChannels = 0;
+        float noiseStep = 0;
+        float thresholdScale = 0;
+        int64_t numWarmup = 0;
+
+        // structure-of-arrays channel state
+        float noise[RCB_FILTER_MAX_CHANNELS];           // running median of |x|
+        float previous[RCB_FILTER_MAX_CHANNELS];
+        int64_t deadUntil[RCB_FILTER_MAX_CHANNELS];     // row index the channel can fire again at
+        int64_t row = 0;
+
+        std::atomic<uint32_t> counts[RCB_FILTER_MAX_CHANNELS];
+        std::atomic<float> thresholds[RCB_FILTER_MAX_CHANNELS];
+    };
+}
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+#include "RcbTelemetry.h"
+
+#include <cstdio>
+
+using namespace RcbWifiNode;
+
+void RcbHistogram::reset()
+{
+	for (auto& bucket : buckets)
+		bucket.store(0, std::memory_order_relaxed);
+
+	count.store(0, std::memory_order_relaxed);
+	sum.store(0, std::memory_order_relaxed);
+	max.store(0, std::memory_order_relaxed);
+}
+
+double RcbHistogram::getMean() const
+{
+	uint64_t n = getCount();
+	return n > 0 ? double(sum.load(std::memory_order_relaxed)) / double(n) : 0.0;
+}
+
+uint64_t RcbHistogram::getPercentile(double p) const
+{
+	uint64_t n = getCount();
+	uint64_t target = uint64_t(p * double(n));
+	uint64_t seen = 0;
+
+	for (int b = 0; b < RCB_HIST_BUCKETS; b++)
+	{
+		seen += buckets[b].load(std::memory_order_relaxed);
+		if (seen > target || (seen == n && seen > 0))
+			return b == RCB_HIST_BUCKETS - 1 ? getMax() : getBucketLimit(b);
+	}
+
+	return 0;
+}
+
+void RcbHistogram::appendJson(std::string& json) const
+{
+	char text[160];
+	snprintf(text, sizeof(text), "{\"count\":%llu,\"mean\":%.1f,\"p50\":%llu,\"p99\":%llu,\"max\":%llu,\"buckets\":[",
+		(unsigned long long)getCount(), getMean(), (unsigned long long)getPercentile(0.5),
+		(unsigned long long)getPercentile(0.99), (unsigned long long)getMax());
+	json += text;
+
+	bool first = true;
+
+	for (int b = 0; b < RCB_HIST_BUCKETS; b++)
+	{
+		uint64_t n = buckets[b].load(std::memory_order_relaxed);
+		if (n == 0)
+			continue;
+
+		// the last bucket is open ended, its limit is the largest value seen
+		uint64_t limit = b == RCB_HIST_BUCKETS - 1 ? getMax() : getBucketLimit(b);
+		snprintf(text, sizeof(text), "%s[%llu,%llu]", first ? "" : ",", (unsigned long long)limit, (unsigned long long)n);
+		json += text;
+		first = false;
+	}
+
+	json += "]}";
+}
+
+void RcbTelemetry::reset()
+{
+	interArrivalUs.reset();
+	lossBurst.reset();
+	decodeNs.reset();
+	pushUs.reset();
+	ringDepth.reset();
+	socketQueueBytes.reset();
+	counts.publish(RcbStreamCounts());
+	rxToBufferUs.reset();
+}
+
+void RcbTelemetry::appendJson(std::string& json) const
+{
+	json += "\"interArrivalUs\":";
+	interArrivalUs.appendJson(json);
+	json += ",\"lossBurst\":";
+	lossBurst.appendJson(json);
+	json += ",\"decodeNs\":";
+	decodeNs.appendJson(json);
+	json += ",\"pushUs\":";
+	pushUs.appendJson(json);
+	json += ",\"ringDepth\":";
+	ringDepth.appendJson(json);
+	json += ",\"socketQueueBytes\":";
+	socketQueueBytes.appendJson(json);
+	json += ",\"rxToBufferUs\":";
+	rxToBufferUs.appendJson(json);
+}
@@ -0,0 +1,210 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+
+#ifndef __RCBTELEMETRYH__
+#define __RCBTELEMETRYH__
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "RcbSequence.h"
+
+// Histogram buckets: 0, then [2^(b-1), 2^b) for b = 1 to 31, the last one also takes everything larger
+const int RCB_HIST_BUCKETS = 32;
+
+namespace RcbWifiNode
+{
+    /**
+        Log2 histogram of one quantity, e.g. microseconds between packets.
+
+        Written by one thread, the DataThread, without locks or read-modify-write atomics;
+        any thread can read it.  A snapshot read while it is being written may be off by the
+        last few values, which does not matter for monitoring.
+    */
+    class RcbHistogram
+    {
+    public:
+        void add(uint64_t value)
+        {
+            const int b = getBucket(value);
+
+            buckets[b].store(buckets[b].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            sum.store(sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+
+            if (value > max.load(std::memory_order_relaxed))
+                max.store(value, std::memory_order_relaxed);
+        }
+
+        /** Only call while the writer is stopped */
+        void reset();
+
+        uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+        uint64_t getMax() const { return max.load(std::memory_order_relaxed); }
+        double getMean() const;
+
+        /** Upper end of the bucket holding the p-th fraction of the values, 0 <= p <= 1 */
+        uint64_t getPercentile(double p) const;
+
+        /** Appends {"count":..,"mean":..,"p50":..,"p99":..,"max":..,"buckets":[[upper,count],..]}, only non-empty buckets */
+        void appendJson(std::string& json) const;
+
+        static int getBucket(uint64_t value)
+        {
+            int b = 0;
+            while (value != 0 && b < RCB_HIST_BUCKETS - 1)
+            {
+                value >>= 1;
+                b++;
+            }
+            return b;
+        }
+
+        /** Largest value that goes in bucket b */
+        static uint64_t getBucketLimit(int b) { return b == 0 ? 0 : (uint64_t(1) << b) - 1; }
+
+    private:
+        std::atomic<uint64_t> buckets[RCB_HIST_BUCKETS] = {};
+        std::atomic<uint64_t> count{ 0 };
+        std::atomic<uint64_t> sum{ 0 };
+        std::atomic<uint64_t> max{ 0 };
+    };
+
+    /** Packet sequence counters, clock fit and reorder depths of one RCB at one moment */
+    struct RcbStreamCounts
+    {
+        uint32_t seqNum = 0;        // last seqNum received
+        uint32_t hit = 0;
+        uint32_t miss = 0;
+        uint32_t delayed = 0;
+        uint32_t restarts = 0;
+        uint32_t concealed = 0;     // packets filled in
+        uint32_t shortPackets = 0;  // dropped as shorter than the settings need
+        uint32_t auxDropped = 0;    // aux rows dropped on a full output block
+
+        // RcbClockRecovery
+        bool clockLocked = false;
+        double driftPpm = 0;
+        double jitter = 0;          // seconds
+        uint32_t clockRejected = 0;
+        uint32_t clockResyncs = 0;
+
+        // RcbReorderWindow histogram
+        uint32_t reorderDepth[RCB_REORDER_HIST_SIZE] = {};
+    };
+
+    /**
+        The counters of the DataThread, published after each batch of packets so other threads
+        never read the fields it is writing.  Each value is consistent, the set may be one batch apart.
+    */
+    class RcbStreamCounters
+    {
+    public:
+        void publish(const RcbStreamCounts& counts)
+        {
+            seqNum.store(counts.seqNum, std::memory_order_relaxed);
+            hit.store(counts.hit, std::memory_order_relaxed);
+            miss.store(counts.miss, std::memory_order_relaxed);
+            delayed.store(counts.delayed, std::memory_order_relaxed);
+            restarts.store(counts.restarts, std::memory_order_relaxed);
+            concealed.store(counts.concealed, std::memory_order_relaxed);
+            shortPackets.store(counts.shortPackets, std::memory_order_relaxed);
+            auxDropped.store(counts.auxDropped, std::memory_order_relaxed);
+
+            clockLocked.store(counts.clockLocked, std::memory_order_relaxed);
+            driftPpm.store(counts.driftPpm, std::memory_order_relaxed);
+            jitter.store(counts.jitter, std::memory_order_relaxed);
+            clockRejected.store(counts.clockRejected, std::memory_order_relaxed);
+            clockResyncs.store(counts.clockResyncs, std::memory_order_relaxed);
+
+            for (int i = 0; i < RCB_REORDER_HIST_SIZE; i++)
+                reorderDepth[i].store(counts.reorderDepth[i], std::memory_order_relaxed);
+        }
+
+        RcbStreamCounts get() const
+        {
+            RcbStreamCounts counts;
+            counts.seqNum = seqNum.load(std::memory_order_relaxed);
+            counts.hit = hit.load(std::memory_order_relaxed);
+            counts.miss = miss.load(std::memory_order_relaxed);
+            counts.delayed = delayed.load(std::memory_order_relaxed);
+            counts.restarts = restarts.load(std::memory_order_relaxed);
+            counts.concealed = concealed.load(std::memory_order_relaxed);
+            counts.shortPackets = shortPackets.load(std::memory_order_relaxed);
+            counts.auxDropped = auxDropped.load(std::memory_order_relaxed);
+
+            counts.clockLocked = clockLocked.load(std::memory_order_relaxed);
+            counts.driftPpm = driftPpm.load(std::memory_order_relaxed);
+            counts.jitter = jitter.load(std::memory_order_relaxed);
+            counts.clockRejected = clockRejected.load(std::memory_order_relaxed);
+            counts.clockResyncs = clockResyncs.load(std::memory_order_relaxed);
+
+            for (int i = 0; i < RCB_REORDER_HIST_SIZE; i++)
+                counts.reorderDepth[i] = reorderDepth[i].load(std::memory_order_relaxed);
+
+            return counts;
+        }
+
+    private:
+        std::atomic<uint32_t> seqNum{ 0 };
+        std::atomic<uint32_t> hit{ 0 };
+        std::atomic<uint32_t> miss{ 0 };
+        std::atomic<uint32_t> delayed{ 0 };
+        std::atomic<uint32_t> restarts{ 0 };
+        std::atomic<uint32_t> concealed{ 0 };
+        std::atomic<uint32_t> shortPackets{ 0 };
+        std::atomic<uint32_t> auxDropped{ 0 };
+
+        std::atomic<bool> clockLocked{ false };
+        std::atomic<double> driftPpm{ 0 };
+        std::atomic<double> jitter{ 0 };
+        std::atomic<uint32_t> clockRejected{ 0 };
+        std::atomic<uint32_t> clockResyncs{ 0 };
+
+        std::atomic<uint32_t> reorderDepth[RCB_REORDER_HIST_SIZE] = {};
+    };
+
+    /** Streaming health of one RCB, recorded by the DataThread as it processes packets */
+    struct RcbTelemetry
+    {
+        RcbStreamCounters counts;       // sequence counters, clock fit and reorder depths for other threads
+        RcbHistogram interArrivalUs;    // host receive time between consecutive packets
+        RcbHistogram lossBurst;         // packets lost in each gap
+        RcbHistogram decodeNs;          // packet decode, per packet
+        RcbHistogram pushUs;            // DataBuffer push, per batch
+        RcbHistogram ringDepth;         // packets waiting in the packet ring when the DataThread got to them
+        RcbHistogram socketQueueBytes;  // bytes in the kernel socket receive queue when the reader thread woke up to read it, recorded by that thread
+        RcbHistogram rxToBufferUs;      // packet receive time, kernel timestamp where available, to the end of its DataBuffer push
+
+        /** Only call while the DataThread is stopped */
+        void reset();
+
+        /** Appends "interArrivalUs":{..},"lossBurst":{..},... without the enclosing braces */
+        void appendJson(std::string& json) const;
+    };
+}
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "RcbTtlInput.h"
+
+#include <algorithm>
+
+using namespace RcbWifiNode;
+
+void RcbTtlInput::reset()
+{
+	state = 0;
+	pending = 0;
+
+	for (int line = 0; line < RCB_NUM_DIGITAL_INPUTS; line++)
+	{
+		pendingSince[line] = 0;
+		numEdges[line].store(0, std::memory_order_relaxed);
+		lastEdge[line].store(-1, std::memory_order_relaxed);
+	}
+}
+
+void RcbTtlInput::update(uint16_t input, int64_t firstSample, int numSamples, unsigned long long* words, uint64_t otherBits)
+{
+	const uint16_t differs = input ^ state;
+
+	// lines back at their level drop the pending change, newly differing ones start one
+	const uint16_t started = differs & ~pending;
+	pending = differs;
+
+	if (pending == 0)
+	{
+		std::fill(words, words + numSamples, otherBits | state);
+		return;
+	}
+
+	for (int line = 0; line < RCB_NUM_DIGITAL_INPUTS; line++)
+		if ((started >> line) & 1)
+			pendingSince[line] = firstSample;
+
+	// changes taken in this packet, by sample
+	int64_t changeSample[RCB_NUM_DIGITAL_INPUTS];
+	uint16_t changeMask[RCB_NUM_DIGITAL_INPUTS];
+	int numChanges = 0;
+
+	for (int line = 0; line < RCB_NUM_DIGITAL_INPUTS; line++)
+	{
+		if (!((pending >> line) & 1))
+			continue;
+
+		const int64_t at = std::max(pendingSince[line] + debounceSamples, firstSample);
+
+		if (at >= firstSample + numSamples)
+			continue;
+
+		int i = 0;
+		while (i < numChanges && changeSample[i] != at)
+			i++;
+
+		if (i == numChanges)
+		{
+			changeSample[numChanges] = at;
+			changeMask[numChanges++] = 0;
+		}
+
+		changeMask[i] |= uint16_t(1u << line);
+		numEdges[line].store(numEdges[line].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		lastEdge[line].store(at, std::memory_order_relaxed);
+	}
+
+	// runs of constant state between the changes
+	int done = 0;
+
+	while (numChanges > 0)
+	{
+		int first = 0;
+		for (int i = 1; i < numChanges; i++)
+			if (changeSample[i] < changeSample[first])
+				first = i;
+
+		const int run = int(changeSample[first] - firstSample);
+		std::fill(words + done, words + run, otherBits | state);
+		done = run;
+
+		state ^= changeMask[first];
+		pending &= ~changeMask[first];
+
+		changeSample[first] = changeSample[--numChanges];
+		changeMask[first] = changeMask[numChanges];
+	}
+
+	std::fill(words + done, words + numSamples, otherBits | state);
+}
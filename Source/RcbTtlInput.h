@@ -0,0 +1,80 @@
+/*
+ ------------------------------------------------------------------
+
+ This file is part of the Open Ephys GUI
+ Copyright (C) 2024 Open Ephys
+ Copyright (C) 2024 DSP Wireless, Inc.
+
+ ------------------------------------------------------------------
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#ifndef __RCBTTLINPUTH__
+#define __RCBTTLINPUTH__
+
+#include <atomic>
+#include <cstdint>
+
+// Digital input lines in the RCB packet header word
+const int RCB_NUM_DIGITAL_INPUTS = 16;
+
+namespace RcbWifiNode
+{
+    /**
+        Debounced RCB digital inputs, tracked as transitions.
+
+        The RCB reports its inputs once per packet, so a change is known to the packet.  A line
+        change is taken once the new level has been reported for debounceSamples samples and lands
+        on that exact sample, the first sample of the reporting packet when there is no debounce.
+        A level that reverts sooner is dropped as a glitch.  The TTL words of a packet are filled
+        in runs between the transitions instead of sample by sample.
+    */
+    class RcbTtlInput
+    {
+    public:
+        /** 0 takes every change at once */
+        void setup(int debounceSamples_) { debounceSamples = debounceSamples_ > 0 ? debounceSamples_ : 0; reset(); }
+
+        /** Forgets the state, all lines low */
+        void reset();
+
+        int getDebounceSamples() const { return debounceSamples; }
+
+        /** Debounced state of the lines */
+        uint16_t getState() const { return state; }
+
+        /**
+            Takes the input word reported for samples firstSample to firstSample + numSamples - 1 and fills
+            their TTL words with the debounced state, ORed with otherBits.  The pointer type is that of JUCE uint64.
+        */
+        void update(uint16_t input, int64_t firstSample, int numSamples, unsigned long long* words, uint64_t otherBits);
+
+        /** Readable from any thread while streaming */
+        uint32_t getNumEdges(int line) const { return numEdges[line].load(std::memory_order_relaxed); }
+        int64_t getLastEdge(int line) const { return lastEdge[line].load(std::memory_order_relaxed); }
+
+    private:
+        int debounceSamples = 0;
+        uint16_t state = 0;
+        uint16_t pending = 0;                           // lines whose input differs from state
+        int64_t pendingSince[RCB_NUM_DIGITAL_INPUTS];   // first sample each pending line was reported at
+
+        std::atomic<uint32_t> numEdges[RCB_NUM_DIGITAL_INPUTS];
+        std::atomic<int64_t> lastEdge[RCB_NUM_DIGITAL_INPUTS];
+    };
+}
+
+#endif
@@ -47,15 +47,13 @@ sample_rate(DEFAULT_SAMPLE_RATE)
 {
     // in RCB case auxbuffer size depends on num channels
     // these settings are recalculated in resizeBuffers() below
-	sourceBuffers.add(new DataBuffer(num_channels, 10000));
-	recvBufSize = 40 + (((num_channels + 2) * num_samp) * 2);
-	recvbuf = (uint16_t*)malloc(recvBufSize);
+	sourceBuffers.add(new DataBuffer(num_channels, DATA_BUFFER_SIZE));
 
-	convBufSize = 0 + (((num_channels)*num_samp) * 4);
-	//convBufSize = 0 + (((num_channels + 3)*num_samp) * 4); // with aux
-	convbuf = (float*)malloc(convBufSize);
+	control = std::make_unique<RcbControlClient>();
 
-	auxbuf = (uint16_t*)malloc(8*num_samp);
+	// device 0 is always present and follows the editor settings
+	rcbDevices.add(new RcbDevice());
+	updatePrimaryDevice();
 }
 
 std::unique_ptr<GenericEditor> RcbWifi::createEditor(SourceNode* sn)
@@ -67,20 +65,24 @@ std::unique_ptr<GenericEditor> RcbWifi::createEditor(SourceNode* sn)
 
 RcbWifi::~RcbWifi()
 {
-	free(recvbuf);
-	free(convbuf);
-	free(auxbuf);
-	if (connected == true)
-	{
-		socket->shutdown();  // check if this is needed.
-        connected = false;
-	}
+	receiver.reset();
+	replay.reset();
+	capture.reset();
+
+	for (auto device : rcbDevices)
+		device->disconnect();  // check if this is needed.
+	connected = false;
     
     if (initPassed == true)
     {
-        // send OFF message to RCB if GUI crashes or if user exits without stopping record 
-        sendRCBTriggerPost(ipNumStr, "__SL_P_ULD=OFF");
+        // send OFF message to RCB if GUI crashes or if user exits without stopping record.
+		// short timeout, the message thread waits for it below
+		for (auto device : rcbDevices)
+			control->post(device->ipNumStr, "__SL_P_ULD=OFF", nullptr, RCB_SHUTDOWN_REQUEST_TIMEOUT_MS);
     }
+
+	// waits for the OFF messages to go out
+	control.reset();
 }
 
 
@@ -90,45 +92,1124 @@ RcbWifi::~RcbWifi()
     
 //}
 
-void RcbWifi::handleBroadcastMessage(String msg)
-{
+void RcbWifi::handleBroadcastMessage(String msg)
+{
+
+}
+
+String RcbWifi::handleConfigMessage(String msg)
+{
+	// DEVICES                               returns the aggregator devices
+	// DEVICES ip:port:channels:start,...    sets the aggregator devices, NONE removes them
+	// CONCEAL                               returns the packet loss concealment mode
+	// CONCEAL OFF|ZERO|HOLD|LINEAR          sets it
+	// REORDER                               returns the reorder window and depth distribution of each device
+	// REORDER <packets> or REORDER <n>ms    sets the reorder window, 0 turns it off
+	// CLOCK                                 returns the sample clock drift and jitter of each device
+	// CONTROL                               returns the HTTP control connection round trip times of each device
+	// INIT                                  returns the init mode and the tokens the last init sent to each device
+	// INIT FULL|DIFF|COMBINED               sets which init tokens are sent
+	// STATS                                 returns the streaming health of each device as JSON
+	// CAPTURE                               returns the capture state
+	// CAPTURE <path> [segment MB]           journals all received packets to path_<time>_000.rcbcap from the next start, OFF stops
+	// REPLAY                                returns the replay state
+	// REPLAY <file> [REALTIME|MAX]          streams a capture instead of the RCBs from the next start, OFF goes back to the RCBs
+	// PRIORITY, AFFINITY, RCVBUF            return the thread scheduling and socket buffers granted at the last start
+	// PRIORITY NORMAL|HIGH|REALTIME         sets the priority of the socket reader thread and the DataThread
+	// AFFINITY <cpu>[,<cpu>]|OFF            pins the socket reader thread, and the DataThread, to CPUs
+	// RCVBUF <kB>                           sets the socket receive buffer, 0 leaves the OS default
+	// FILTER                                returns the on-host filters
+	// FILTER HPF <Hz> [2|4]|OFF             sets the high-pass cutoff and order of the amplifier channels
+	// FILTER NOTCH 50|60 [harmonics]|OFF    sets the line noise notch and how many of its harmonics are notched too
+	// FILTER OFF                            turns both off
+	// REFERENCE                             returns the re-referencing mode and group
+	// REFERENCE CAR|MEDIAN [channels]|OFF   re-references each device to the mean or median of channels, e.g. 1-8,12, all by default
+	// SPIKES                                returns the spike detection settings and each channel's spike count and threshold
+	// SPIKES <k> [refractory]|OFF           detects negative crossings of k noise deviations, a channel fires at most once per refractory samples.
+	//                                       each spike is a one-sample pulse on TTL line 16 + channel (0 based), not a spike event
+	// TTL                                   returns the digital input debounce, and each input's edge count and last edge sample
+	// TTL <ms>|OFF                          drops digital input changes that last less than ms
+	// LFP                                   returns the LFP stream rate, and each device's actual rate and filter delay
+	// LFP <Hz>|OFF                          publishes a low-pass decimated copy of each device's amplifier channels as a second stream
+	// LATENCY                               returns the latency mode and the receive to DataBuffer latency of each device
+	// LATENCY LOW|NORMAL                    LOW busy polls the sockets and packet rings, burning a core per thread
+	StringArray tokens = StringArray::fromTokens(msg.trim(), " ", "\"");
+
+	if (tokens.size() > 1 && CoreServices::getAcquisitionStatus())
+		return "Cannot change settings while acquiring";
+
+	if (tokens[0].equalsIgnoreCase("CONCEAL"))
+	{
+		if (tokens.size() > 1)
+			return setConcealMode(tokens[1]);
+
+		return getConcealMode();
+	}
+
+	if (tokens[0].equalsIgnoreCase("CLOCK"))
+		return getClockInfo();
+
+	if (tokens[0].equalsIgnoreCase("CONTROL"))
+		return getControlInfo();
+
+	if (tokens[0].equalsIgnoreCase("STATS"))
+		return getStats();
+
+	if (tokens[0].equalsIgnoreCase("CAPTURE"))
+	{
+		if (tokens.size() > 1)
+		{
+			String result = setCapture(tokens[1].unquoted(), tokens[2]);
+
+			if (result.startsWith("Invalid"))
+				return result;
+		}
+
+		return getCaptureInfo();
+	}
+
+	if (tokens[0].equalsIgnoreCase("REPLAY"))
+	{
+		if (tokens.size() > 1)
+			setReplay(tokens[1].unquoted(), !tokens[2].equalsIgnoreCase("MAX"));
+
+		return getReplayInfo();
+	}
+
+	if (tokens[0].equalsIgnoreCase("PRIORITY") || tokens[0].equalsIgnoreCase("AFFINITY") || tokens[0].equalsIgnoreCase("RCVBUF"))
+	{
+		if (tokens.size() > 1)
+		{
+			String result = tokens[0].equalsIgnoreCase("PRIORITY") ? setThreadPriority(tokens[1])
+				: tokens[0].equalsIgnoreCase("AFFINITY") ? setAffinity(tokens[1])
+				: setReceiveBufferSize(tokens[1]);
+
+			if (result.startsWith("Invalid"))
+				return result;
+		}
+
+		return getSchedulingInfo();
+	}
+
+	if (tokens[0].equalsIgnoreCase("FILTER"))
+	{
+		if (tokens.size() > 1)
+		{
+			String result = setFilter(tokens[1], tokens[2], tokens[3]);
+
+			if (result.startsWith("Invalid"))
+				return result;
+		}
+
+		return getFilter();
+	}
+
+	if (tokens[0].equalsIgnoreCase("REFERENCE"))
+	{
+		if (tokens.size() > 1)
+		{
+			String result = setReference(tokens[1], tokens[2]);
+
+			if (result.startsWith("Invalid"))
+				return result;
+		}
+
+		return getReference();
+	}
+
+	if (tokens[0].equalsIgnoreCase("SPIKES"))
+	{
+		if (tokens.size() > 1)
+		{
+			bool wasEnabled = spikeSettings.enabled;
+			String result = setSpikeDetection(tokens[1], tokens[2]);
+
+			if (result.startsWith("Invalid"))
+				return result;
+
+			// the spike lines change the TTL line count
+			if (spikeSettings.enabled != wasEnabled)
+				CoreServices::updateSignalChain(sn->getEditor());
+		}
+
+		return getSpikeInfo();
+	}
+
+	if (tokens[0].equalsIgnoreCase("TTL"))
+	{
+		if (tokens.size() > 1)
+		{
+			String result = setTtlDebounce(tokens[1]);
+
+			if (result.startsWith("Invalid"))
+				return result;
+		}
+
+		return getTtlInfo();
+	}
+
+	if (tokens[0].equalsIgnoreCase("LFP"))
+	{
+		if (tokens.size() > 1)
+		{
+			String result = setLfp(tokens[1]);
+
+			if (result.startsWith("Invalid"))
+				return result;
+
+			// the LFP streams come and go with the setting
+			CoreServices::updateSignalChain(sn->getEditor());
+		}
+
+		return getLfpInfo();
+	}
+
+	if (tokens[0].equalsIgnoreCase("LATENCY"))
+	{
+		if (tokens.size() > 1)
+		{
+			String result = setLatencyMode(tokens[1]);
+
+			if (result.startsWith("Invalid"))
+				return result;
+		}
+
+		return getLatencyInfo();
+	}
+
+	if (tokens[0].equalsIgnoreCase("INIT"))
+	{
+		if (tokens.size() > 1)
+			return setInitMode(tokens[1]);
+
+		return getInitInfo();
+	}
+
+	if (tokens[0].equalsIgnoreCase("REORDER"))
+	{
+		if (tokens.size() > 2)
+			return "Invalid reorder window " + tokens.joinIntoString(" ", 1) + ", expected packets or a time in ms, e.g. 4 or 5ms";
+
+		if (tokens.size() > 1)
+		{
+			String result = setReorderWindow(tokens[1]);
+
+			if (result.startsWith("Invalid"))
+				return result;
+		}
+
+		return getReorderInfo();
+	}
+
+	if (tokens[0].equalsIgnoreCase("DEVICES"))
+	{
+		if (tokens.size() > 1)
+		{
+			String result = setExtraDevices(tokens[1]);
+			CoreServices::updateSignalChain(sn->getEditor());
+			return result;
+		}
+
+		return getExtraDevices();
+	}
+
+	return "";
+}
+
+String RcbWifi::getConcealMode()
+{
+	return concealModeNames[(int)concealMode];
+}
+
+String RcbWifi::setConcealMode(String modeStr)
+{
+	int mode = concealModeNames.indexOf(modeStr.trim().toUpperCase());
+
+	if (mode < 0)
+		return "Invalid conceal mode " + modeStr + ", expected " + concealModeNames.joinIntoString("|");
+
+	concealMode = (RcbConcealMode)mode;
+
+	for (auto device : rcbDevices)
+		device->concealMode = concealMode;
+
+	LOGC("[dspw] RCB packet loss concealment = ", getConcealMode());
+	return getConcealMode();
+}
+
+String RcbWifi::getInitMode()
+{
+	return initModeNames[(int)initMode];
+}
+
+String RcbWifi::setInitMode(String modeStr)
+{
+	int mode = initModeNames.indexOf(modeStr.trim().toUpperCase());
+
+	if (mode < 0)
+		return "Invalid init mode " + modeStr + ", expected " + initModeNames.joinIntoString("|");
+
+	initMode = (RcbInitMode)mode;
+
+	LOGC("[dspw] RCB init mode = ", getInitMode());
+	return getInitMode();
+}
+
+String RcbWifi::getInitInfo()
+{
+	String info = getInitMode();
+
+	for (auto device : rcbDevices)
+	{
+		if (lastInitSent.containsKey(device->ipNumStr))
+			info << "\n" << device->ipNumStr << " sent " << lastInitSent[device->ipNumStr] << " tokens";
+	}
+
+	return info;
+}
+
+String RcbWifi::getThreadPriority()
+{
+	return threadPriorityNames[(int)threadPriority];
+}
+
+String RcbWifi::setThreadPriority(String priorityStr)
+{
+	int priority = threadPriorityNames.indexOf(priorityStr.trim().toUpperCase());
+
+	if (priority < 0)
+		return "Invalid priority " + priorityStr + ", expected " + threadPriorityNames.joinIntoString("|");
+
+	threadPriority = (RcbThreadPriority)priority;
+
+	LOGC("[dspw] RCB thread priority = ", getThreadPriority());
+	return getThreadPriority();
+}
+
+String RcbWifi::getAffinity()
+{
+	if (receiverCpu < 0)
+		return "OFF";
+
+	return dataThreadCpu < 0 ? String(receiverCpu) : String(receiverCpu) + "," + String(dataThreadCpu);
+}
+
+String RcbWifi::setAffinity(String cpuStr)
+{
+	cpuStr = cpuStr.trim();
+
+	if (cpuStr.equalsIgnoreCase("OFF"))
+	{
+		receiverCpu = -1;
+		dataThreadCpu = -1;
+	}
+	else
+	{
+		StringArray cpus = StringArray::fromTokens(cpuStr, ",", "");
+		const int numCpus = SystemStats::getNumCpus();
+
+		for (auto& cpu : cpus)
+		{
+			if (!cpu.trim().containsOnly("0123456789") || cpu.getIntValue() >= numCpus)
+				return "Invalid CPU " + cpu + ", expected 0 to " + String(numCpus - 1) + " or OFF";
+		}
+
+		receiverCpu = cpus[0].getIntValue();
+		dataThreadCpu = cpus.size() > 1 ? cpus[1].getIntValue() : -1;
+	}
+
+	LOGC("[dspw] RCB thread affinity = ", getAffinity());
+	return getAffinity();
+}
+
+String RcbWifi::getReceiveBufferSize()
+{
+	return String(receiveBufferKB);
+}
+
+String RcbWifi::setReceiveBufferSize(String sizeStr)
+{
+	sizeStr = sizeStr.trim();
+
+	if (!sizeStr.containsOnly("0123456789") || sizeStr.isEmpty())
+		return "Invalid receive buffer " + sizeStr + ", expected a size in kB";
+
+	// kept below 1 GB so the size still fits the socket option in bytes
+	receiveBufferKB = jmin(sizeStr.getIntValue(), 1024 * 1024);
+
+	LOGC("[dspw] RCB socket receive buffer = ", receiveBufferKB, " kB");
+	return getReceiveBufferSize();
+}
+
+String RcbWifi::getSchedulingInfo()
+{
+	String info;
+	info << "priority " << getThreadPriority() << ", affinity " << getAffinity() << ", rcvbuf " << getReceiveBufferSize() << " kB";
+
+	const ScopedLock sl(schedulingLock);
+
+	if (receiver != nullptr)
+		receiverSchedulingInfo = receiver->getSchedulingInfo();
+
+	if (receiverSchedulingInfo.isNotEmpty())
+		info << "\nreceiver: " << receiverSchedulingInfo;
+
+	if (dataThreadSchedulingInfo.isNotEmpty())
+		info << "\nDataThread: " << dataThreadSchedulingInfo;
+
+	for (auto device : rcbDevices)
+	{
+		if (device->receiveBufferBytes > 0)
+			info << "\n" << device->ipNumStr << ":" << String(device->port) << " rcvbuf " << String(device->receiveBufferBytes / 1024) << " kB";
+	}
+
+	return info;
+}
+
+String RcbWifi::getFilter()
+{
+	String info;
+
+	if (filterSettings.highPassHz > 0)
+		info << "HPF " << String(filterSettings.highPassHz) << " Hz order " << String(filterSettings.highPassOrder);
+
+	if (filterSettings.notchHz > 0)
+		info << (info.isEmpty() ? "" : ", ") << "NOTCH " << String(filterSettings.notchHz) << " Hz x" << String(filterSettings.notchHarmonics);
+
+	return info.isEmpty() ? "OFF" : info;
+}
+
+String RcbWifi::setFilter(String filterStr, String valueStr, String extraStr)
+{
+	RcbFilterSettings settings = filterSettings;
+	filterStr = filterStr.trim().toUpperCase();
+	bool off = valueStr.equalsIgnoreCase("OFF") || valueStr == "0";
+
+	if (filterStr == "OFF")
+	{
+		settings.highPassHz = 0;
+		settings.notchHz = 0;
+	}
+	else if (filterStr == "HPF")
+	{
+		float hz = valueStr.getFloatValue();
+
+		if (!off && (hz <= 0 || (sample_rate > 0 && hz >= 0.45f * sample_rate)))
+			return "Invalid high-pass cutoff " + valueStr + ", expected Hz below " + String(int(0.45f * sample_rate)) + " or OFF";
+
+		settings.highPassHz = off ? 0 : hz;
+		if (extraStr.isNotEmpty())
+			settings.highPassOrder = extraStr.getIntValue() >= 4 ? 4 : 2;
+	}
+	else if (filterStr == "NOTCH")
+	{
+		float hz = valueStr.getFloatValue();
+
+		if (!off && hz != 50 && hz != 60)
+			return "Invalid notch " + valueStr + ", expected 50|60|OFF";
+
+		settings.notchHz = off ? 0 : hz;
+		if (extraStr.isNotEmpty())
+			settings.notchHarmonics = jlimit(1, RCB_FILTER_MAX_SECTIONS - 2, extraStr.getIntValue());
+	}
+	else
+	{
+		return "Invalid filter " + filterStr + ", expected HPF|NOTCH|OFF";
+	}
+
+	setFilterSettings(settings);
+	return getFilter();
+}
+
+void RcbWifi::setFilterSettings(const RcbFilterSettings& settings)
+{
+	filterSettings = settings;
+
+	for (auto device : rcbDevices)
+		device->setFilters(filterSettings);
+
+	LOGC("[dspw] RCB on-host filters = ", getFilter());
+}
+
+String RcbWifi::getReference()
+{
+	if (referenceMode == RcbReferenceMode::OFF)
+		return "OFF";
+
+	if (referenceMask == 0)
+		return referenceModeNames[(int)referenceMode] + " all";
+
+	// channel ranges, 1 based
+	StringArray ranges;
+	for (int c = 0; c < 32; c++)
+	{
+		if (!((referenceMask >> c) & 1))
+			continue;
+
+		int last = c;
+		while (last + 1 < 32 && ((referenceMask >> (last + 1)) & 1))
+			last++;
+
+		ranges.add(last > c ? String(c + 1) + "-" + String(last + 1) : String(c + 1));
+		c = last;
+	}
+
+	return referenceModeNames[(int)referenceMode] + " " + ranges.joinIntoString(",");
+}
+
+String RcbWifi::setReference(String modeStr, String channelsStr)
+{
+	int mode = referenceModeNames.indexOf(modeStr.trim().toUpperCase());
+
+	if (mode < 0)
+		return "Invalid reference " + modeStr + ", expected " + referenceModeNames.joinIntoString("|");
+
+	uint32_t mask = 0;
+	channelsStr = channelsStr.trim();
+
+	if (channelsStr.isNotEmpty() && !channelsStr.equalsIgnoreCase("all"))
+	{
+		for (auto& range : StringArray::fromTokens(channelsStr, ",", ""))
+		{
+			int first = range.upToFirstOccurrenceOf("-", false, false).getIntValue();
+			int last = range.contains("-") ? range.fromFirstOccurrenceOf("-", false, false).getIntValue() : first;
+
+			if (first < 1 || last < first || last > 32)
+				return "Invalid reference channels " + range + ", expected e.g. 1-8,12 with channels 1 to 32";
+
+			for (int c = first; c <= last; c++)
+				mask |= 1u << (c - 1);
+		}
+	}
+
+	referenceMode = (RcbReferenceMode)mode;
+	referenceMask = mask;
+
+	for (auto device : rcbDevices)
+		device->setReference(referenceMode, referenceMask);
+
+	LOGC("[dspw] RCB re-referencing = ", getReference());
+	return getReference();
+}
+
+String RcbWifi::getSpikeDetection()
+{
+	if (!spikeSettings.enabled)
+		return "OFF";
+
+	return String(spikeSettings.thresholdK) + " x noise, " + String(spikeSettings.refractorySamples) + " samples refractory";
+}
+
+String RcbWifi::setSpikeDetection(String thresholdStr, String refractoryStr)
+{
+	RcbSpikeSettings settings = spikeSettings;
+
+	if (thresholdStr.equalsIgnoreCase("OFF") || thresholdStr == "0")
+	{
+		settings.enabled = false;
+	}
+	else
+	{
+		float k = thresholdStr.getFloatValue();
+
+		if (k <= 0 || k > 50)
+			return "Invalid spike threshold " + thresholdStr + ", expected noise deviations, e.g. 4.5, or OFF";
+
+		settings.enabled = true;
+		settings.thresholdK = k;
+
+		if (refractoryStr.isNotEmpty())
+		{
+			int refractory = refractoryStr.getIntValue();
+
+			if (!refractoryStr.containsOnly("0123456789") || refractory < 1 || refractory > RCB_SPIKE_MAX_REFRACTORY)
+				return "Invalid spike refractory period " + refractoryStr + ", expected 1 to " + String(RCB_SPIKE_MAX_REFRACTORY) + " samples";
+
+			settings.refractorySamples = refractory;
+		}
+	}
+
+	setSpikeSettings(settings);
+	return getSpikeDetection();
+}
+
+void RcbWifi::setSpikeSettings(const RcbSpikeSettings& settings)
+{
+	spikeSettings = settings;
+
+	for (auto device : rcbDevices)
+		device->setSpikeDetection(spikeSettings);
+
+	LOGC("[dspw] RCB spike detection = ", getSpikeDetection());
+}
+
+String RcbWifi::getSpikeInfo()
+{
+	String info = getSpikeDetection();
+
+	if (!spikeSettings.enabled)
+		return info;
+
+	for (auto device : rcbDevices)
+	{
+		const RcbSpikeDetector& detector = device->getSpikeDetector();
+		StringArray counts, thresholds;
+
+		for (int c = 0; c < device->numChannels; c++)
+		{
+			counts.add(String(detector.getCount(c)));
+			thresholds.add(String(detector.getThreshold(c), 1));
+		}
+
+		info << "\n" << device->ipNumStr << ":" << String(device->port)
+			<< " spikes " << counts.joinIntoString(",")
+			<< " thresholds " << thresholds.joinIntoString(",");
+	}
+
+	return info;
+}
+
+String RcbWifi::getTtlDebounce()
+{
+	return ttlDebounceMs > 0 ? String(ttlDebounceMs) + " ms" : String("OFF");
+}
+
+String RcbWifi::setTtlDebounce(String msStr)
+{
+	msStr = msStr.trim();
+	float ms = msStr.equalsIgnoreCase("OFF") ? 0 : msStr.getFloatValue();
+
+	if (ms < 0 || ms > 1000 || (ms == 0 && !msStr.equalsIgnoreCase("OFF") && !msStr.containsOnly("0.")))
+		return "Invalid TTL debounce " + msStr + ", expected ms up to 1000, or OFF";
+
+	ttlDebounceMs = ms;
+
+	for (auto device : rcbDevices)
+		device->setTtlDebounce(ttlDebounceMs);
+
+	LOGC("[dspw] RCB digital input debounce = ", getTtlDebounce());
+	return getTtlDebounce();
+}
+
+String RcbWifi::getTtlInfo()
+{
+	String info = getTtlDebounce();
+
+	for (auto device : rcbDevices)
+	{
+		const RcbTtlInput& input = device->getTtlInput();
+		StringArray lines;
+
+		for (int line = 0; line < RCB_NUM_DIGITAL_INPUTS; line++)
+		{
+			if (input.getNumEdges(line) > 0)
+				lines.add(String(line + 1) + ":" + String(input.getNumEdges(line)) + "@" + String((int64)input.getLastEdge(line)));
+		}
+
+		info << "\n" << device->ipNumStr << ":" << String(device->port)
+			<< " edges " << (lines.size() > 0 ? lines.joinIntoString(" ") : String("none"));
+	}
+
+	return info;
+}
+
+String RcbWifi::getLfp()
+{
+	return lfpRate > 0 ? String(lfpRate) + " Hz" : String("OFF");
+}
+
+String RcbWifi::setLfp(String rateStr)
+{
+	rateStr = rateStr.trim();
+	float rate = rateStr.equalsIgnoreCase("OFF") ? 0 : rateStr.getFloatValue();
+
+	if (rate < 0 || (rate == 0 && !rateStr.equalsIgnoreCase("OFF") && rateStr != "0") || (rate > 0 && rate > sample_rate / 2))
+		return "Invalid LFP rate " + rateStr + ", expected Hz up to half the sample rate, e.g. 1000, or OFF";
+
+	lfpRate = rate;
+
+	LOGC("[dspw] RCB LFP stream = ", getLfp());
+	return getLfp();
+}
+
+int RcbWifi::getLfpFactor(const RcbDevice* device) const
+{
+	if (lfpRate <= 0 || device->sampleRate <= 0)
+		return 0;
+
+	return jlimit(2, RCB_DECIMATOR_MAX_FACTOR, roundToInt(device->sampleRate / lfpRate));
+}
+
+String RcbWifi::getLfpInfo()
+{
+	String info = getLfp();
+
+	if (lfpRate <= 0)
+		return info;
+
+	for (auto device : rcbDevices)
+	{
+		int factor = getLfpFactor(device);
+
+		info << "\n" << device->ipNumStr << ":" << String(device->port)
+			<< " " << String(device->sampleRate / factor, 1) << " Hz (1/" << String(factor) << ")"
+			<< " flat to " << String(0.3f * device->sampleRate / factor, 0) << " Hz"
+			<< " delay " << String(1000.0f * factor * RCB_DECIMATOR_TAPS_PER_OUTPUT / 2 / device->sampleRate, 1) << " ms";
+	}
+
+	return info;
+}
+
+String RcbWifi::getLatencyMode()
+{
+	return lowLatency ? "LOW" : "NORMAL";
+}
+
+String RcbWifi::setLatencyMode(String modeStr)
+{
+	modeStr = modeStr.trim().toUpperCase();
+
+	if (modeStr != "LOW" && modeStr != "NORMAL")
+		return "Invalid latency mode " + modeStr + ", expected LOW|NORMAL";
+
+	lowLatency = modeStr == "LOW";
+
+	LOGC("[dspw] RCB latency mode = ", getLatencyMode());
+	return getLatencyMode();
+}
+
+String RcbWifi::getLatencyInfo()
+{
+	String info = getLatencyMode();
+
+	// from the kernel receive time on Linux, from the socket read elsewhere
+	for (auto device : rcbDevices)
+	{
+		const RcbHistogram& latency = device->telemetry.rxToBufferUs;
+
+		info << "\n" << device->ipNumStr << ":" << String(device->port) << " receive to DataBuffer us: mean "
+			<< String(latency.getMean(), 1) << ", p50 " << String(latency.getPercentile(0.5))
+			<< ", p99 " << String(latency.getPercentile(0.99)) << ", max " << String(latency.getMax());
+
+		if (device->busyPollUs > 0)
+			info << ", busy poll " << String(device->busyPollUs) << " us";
+	}
+
+	return info;
+}
+
+String RcbWifi::setReorderWindow(String windowStr)
+{
+	windowStr = windowStr.trim().toLowerCase();
+
+	if (windowStr.endsWith("ms"))
+	{
+		String msStr = windowStr.dropLastCharacters(2);
+
+		if (msStr.isEmpty() || !msStr.containsOnly("0123456789."))
+			return "Invalid reorder window " + windowStr + ", expected packets or a time in ms, e.g. 4 or 5ms";
+
+		reorderMs = msStr.getFloatValue();
+		reorderPackets = 0;
+	}
+	else
+	{
+		int numPackets = windowStr.getIntValue();
+
+		if (windowStr.isEmpty() || !windowStr.containsOnly("0123456789") || numPackets > RCB_MAX_REORDER_PACKETS)
+			return "Invalid reorder window " + windowStr + ", expected 0 to " + String(RCB_MAX_REORDER_PACKETS) + " packets or a time in ms, e.g. 5ms";
+
+		reorderMs = 0;
+		reorderPackets = numPackets;
+	}
+
+	for (auto device : rcbDevices)
+		applyReorderWindow(device);
+
+	return getReorderWindow();
+}
+
+String RcbWifi::getReorderWindow()
+{
+	return reorderMs > 0 ? String(reorderMs) + "ms" : String(reorderPackets);
+}
+
+void RcbWifi::applyReorderWindow(RcbDevice* device)
+{
+	int numPackets = reorderPackets;
+
+	// packet period is numSamples / sampleRate
+	if (reorderMs > 0 && device->numSamples > 0)
+		numPackets = jmin((int)ceilf(reorderMs * 0.001f * device->sampleRate / device->numSamples), RCB_MAX_REORDER_PACKETS);
+
+	if (numPackets != device->getReorderWindow())
+		device->setReorderWindow(numPackets);
+}
+
+String RcbWifi::getReorderInfo()
+{
+	String info = "window " + getReorderWindow();
+
+	for (int d = 0; d < rcbDevices.size(); d++)
+	{
+		RcbDevice* device = rcbDevices[d];
+		info << "\n" << device->ipNumStr << " " << String(device->getReorderWindow()) << " packets, depth "
+			<< device->getReorderStats();
+	}
+
+	return info;
+}
+
+String RcbWifi::getClockInfo()
+{
+	StringArray info;
+
+	for (auto device : rcbDevices)
+	{
+		const RcbStreamCounts counts = device->getCounts();
+		info.add(device->ipNumStr + (counts.clockLocked ? " locked" : " not locked")
+			+ ", drift " + String(counts.driftPpm, 2) + " ppm"
+			+ ", jitter " + String(counts.jitter * 1000.0, 3) + " ms"
+			+ ", rejected " + String(counts.clockRejected)
+			+ ", resyncs " + String(counts.clockResyncs));
+	}
+
+	return info.joinIntoString("\n");
+}
+
+String RcbWifi::getControlInfo()
+{
+	StringArray info;
+
+	for (auto device : rcbDevices)
+	{
+		RcbControlStats stats = control->getStats(device->ipNumStr);
+		info.add(device->ipNumStr + " requests " + String(stats.numRequests)
+			+ ", failed " + String(stats.numFailed)
+			+ ", connects " + String(stats.numConnects)
+			+ (stats.pipelining ? ", pipelined" : ", not pipelined")
+			+ ", round trip last " + String(stats.lastRoundTripMs, 1)
+			+ " mean " + String(stats.meanRoundTripMs, 1)
+			+ " max " + String(stats.maxRoundTripMs, 1) + " ms");
+	}
+
+	return info.joinIntoString("\n");
+}
+
+String RcbWifi::getStats()
+{
+	// only what the DataThread publishes, the counters and histograms are at most a batch behind
+	std::string json = "{\"timeMs\":" + std::to_string(Time::currentTimeMillis())
+		+ ",\"acquiring\":" + (CoreServices::getAcquisitionStatus() ? "true" : "false")
+		+ ",\"devices\":[";
+
+	for (int d = 0; d < rcbDevices.size(); d++)
+	{
+		RcbDevice* device = rcbDevices[d];
+		const RcbStreamCounts counts = device->getCounts();
+		char text[512];
+
+		// the address is user text, JSON::toString() quotes and escapes it
+		json += (d > 0 ? ",{\"ip\":" : "{\"ip\":") + JSON::toString(var(device->ipNumStr)).toStdString();
+
+		snprintf(text, sizeof(text), ",\"port\":%d,\"seqNum\":%u,\"hit\":%u,\"miss\":%u,\"delayed\":%u,\"restarts\":%u,"
+			"\"concealed\":%u,\"short\":%u,\"auxDropped\":%u,\"ringOverflow\":%u,\"ringHighWater\":%d,\"reorderWindow\":%d,"
+			"\"clock\":{\"locked\":%s,\"driftPpm\":%.3f,\"jitterUs\":%.1f,\"rejected\":%u,\"resyncs\":%u},",
+			device->port, counts.seqNum, counts.hit, counts.miss, counts.delayed, counts.restarts,
+			counts.concealed, counts.shortPackets, counts.auxDropped, device->packetRing.getOverflowCount(), device->packetRing.getHighWaterMark(),
+			device->getReorderWindow(), counts.clockLocked ? "true" : "false", counts.driftPpm, counts.jitter * 1e6,
+			counts.clockRejected, counts.clockResyncs);
+		json += text;
+
+		// packets by how far behind the newest one they arrived, the last entry counts those too late for the window
+		json += "\"reorderDepth\":[";
+		for (int i = 0; i < RCB_REORDER_HIST_SIZE; i++)
+			json += (i > 0 ? "," : "") + std::to_string(counts.reorderDepth[i]);
+		json += "],";
+
+		device->telemetry.appendJson(json);
+		json += "}";
+	}
+
+	json += "]}";
+
+	return String(json);
+}
+
+String RcbWifi::setCapture(String path, String segmentStr)
+{
+	int64 segmentBytes = RCB_CAPTURE_SEGMENT_BYTES;
+
+	if (segmentStr.isNotEmpty())
+	{
+		int segmentMB = segmentStr.getIntValue();
+
+		if (!segmentStr.containsOnly("0123456789") || segmentMB < 1 || segmentMB > RCB_CAPTURE_MAX_SEGMENT_MB)
+			return "Invalid segment size " + segmentStr + ", expected 1 to " + String(RCB_CAPTURE_MAX_SEGMENT_MB) + " MB";
+
+		segmentBytes = int64(segmentMB) * 1024 * 1024;
+	}
+
+	capturePath = path.equalsIgnoreCase("OFF") ? String() : path;
+	captureSegmentBytes = segmentBytes;
+
+	return getCaptureInfo();
+}
+
+String RcbWifi::getCaptureInfo()
+{
+	String info = capturePath.isEmpty() ? "OFF" : capturePath + ", " + String(captureSegmentBytes / (1024 * 1024)) + " MB segments";
+
+	if (capture != nullptr)
+		info << "\nlast capture " << capture->getFirstFile().getFullPathName() << ": " << String(capture->getNumPackets())
+			<< " packets, " << String(capture->getNumBytes() / (1024 * 1024)) << " MB in " << String(capture->getNumSegments())
+			<< " segments, dropped " << String(capture->getNumDropped());
+
+	return info;
+}
+
+void RcbWifi::setReplay(String path, bool realTime)
+{
+	replayPath = path.equalsIgnoreCase("OFF") ? String() : path;
+	replayRealTime = realTime;
+}
+
+String RcbWifi::getReplayInfo()
+{
+	if (replayPath.isEmpty())
+		return "OFF";
+
+	String info = replayPath + (replayRealTime ? ", real time" : ", max speed");
+
+	if (replay != nullptr)
+		info << "\n" << String(replay->getNumPackets()) << " packets replayed, " << String(replay->getNumSkipped()) << " for no device";
+
+	return info;
+}
+
+void RcbWifi::startCapture()
+{
+	// a new capture each acquisition, named by its start time
+	String basePath = capturePath + "_" + Time::getCurrentTime().formatted("%Y%m%d_%H%M%S");
+	Array<RcbCaptureDevice> devices;
+
+	for (auto device : rcbDevices)
+	{
+		RcbCaptureDevice captureDevice = {};
+		device->ipNumStr.copyToUTF8(captureDevice.ipNumStr, sizeof(captureDevice.ipNumStr));
+		captureDevice.port = (uint16_t)device->port;
+		captureDevice.numChannels = (uint16_t)device->numChannels;
+		captureDevice.numSamples = (uint16_t)device->numSamples;
+		captureDevice.auxEnabled = auxEnableState ? 1 : 0;
+		captureDevice.sampleRate = device->sampleRate;
+		devices.add(captureDevice);
+	}
+
+	capture = std::make_unique<RcbCaptureWriter>();
+
+	if (capture->open(basePath, captureSegmentBytes, devices))
+	{
+		LOGC("[dspw] RCB capture to ", capture->getFirstFile().getFullPathName());
+	}
+	else
+	{
+		LOGC("[dspw] RCB capture could not start, streaming without it");
+		capture.reset();
+	}
+}
+
+bool RcbWifi::startReplay()
+{
+	replay = std::make_unique<RcbReplay>(File(replayPath), replayRealTime);
+
+	if (!replay->open())
+	{
+		replay.reset();
+
+		AlertWindow::showMessageBoxAsync(AlertWindow::NoIcon,
+			"Cannot replay " + replayPath,
+			"The file is missing or not an RCB capture.\r\n\r\n"
+			"Send REPLAY OFF to stream from the RCBs again.",
+			"OK");
+		return false;
+	}
+
+	// the decoders are set up from the current settings, which should match the capture
+	const RcbCaptureHeader& header = replay->getHeader();
+
+	for (auto device : rcbDevices)
+	{
+		bool found = false;
+
+		for (uint32_t d = 0; d < header.numDevices; d++)
+		{
+			const RcbCaptureDevice& captured = header.devices[d];
+
+			if (captured.port != device->port)
+				continue;
+
+			found = true;
+
+			if (captured.numChannels != device->numChannels || captured.numSamples != device->numSamples
+				|| (captured.auxEnabled != 0) != auxEnableState)
+				LOGC("[dspw] RCB replay port-", String(device->port), " was captured with ", String(captured.numChannels),
+					" channels, ", String(captured.numSamples), " samples, aux ", String(captured.auxEnabled), ", settings differ");
+		}
+
+		if (!found)
+			LOGC("[dspw] RCB replay has no packets for port-", String(device->port));
+
+		replay->addDevice(device->port, &device->packetRing);
+	}
+
+	for (auto buffer : sourceBuffers)
+		buffer->clear();
+
+	for (auto device : rcbDevices)
+		device->resetCounters();
+
+	LOGC("[dspw] RCB replay of ", replayPath, replayRealTime ? " in real time" : " at max speed");
+
+	replay->startThread();
+	startThread();
+
+	return true;
+}
+
+void RcbWifi::updatePrimaryDevice()
+{
+	RcbDevice* device = rcbDevices[0];
+
+	device->ipNumStr = ipNumStr;
+	device->port = port;
+	device->numChannels = num_channels;
+	device->chShift = chShift;
+	device->numSamples = num_samp;
+	device->sampleRate = sample_rate;
+	device->bitrate = bitrate;
+	device->filterSettings = filterSettings;
+	device->referenceMode = referenceMode;
+	device->referenceMask = referenceMask;
+}
+
+String RcbWifi::getExtraDevices()
+{
+	StringArray devicesStr;
+
+	for (int d = 1; d < rcbDevices.size(); d++)
+	{
+		RcbDevice* device = rcbDevices[d];
+		devicesStr.add(device->ipNumStr + ":" + String(device->port) + ":" + String(device->numChannels) + ":" + String(device->chShift));
+	}
+
+	return devicesStr.size() > 0 ? devicesStr.joinIntoString(",") : "NONE";
+}
+
+String RcbWifi::setExtraDevices(String devicesStr)
+{
+	OwnedArray<RcbDevice> extraDevices;
+	StringArray items = StringArray::fromTokens(devicesStr, ",", "");
+	items.removeEmptyStrings();
+
+	if (!devicesStr.equalsIgnoreCase("NONE"))
+	{
+		for (auto item : items)
+		{
+			StringArray fields = StringArray::fromTokens(item.trim(), ":", "");
+			int numChannels = fields[2].getIntValue();
+			int chStart = fields.size() > 3 ? fields[3].getIntValue() : 1;
+			int format = 0;
+
+			while (format < RCB_NUM_PACKET_FORMATS && RCB_CHANNEL_COUNTS[format] != numChannels)
+				format++;
+
+			if (fields.size() < 3 || IPAddress(fields[0]).toString() != fields[0]
+				|| format == RCB_NUM_PACKET_FORMATS || chStart < 1 || chStart + numChannels - 1 > 32)
+			{
+				LOGC("[dspw] Invalid RCB device ", item);
+				return "Invalid device " + item + ", expected ip:port:channels:start";
+			}
+
+			RcbDevice* device = extraDevices.add(new RcbDevice());
+			device->ipNumStr = fields[0];
+			device->port = fields[1].getIntValue();
+			device->numChannels = numChannels;
+			device->chShift = chStart;
+			device->numSamples = RCB_SAMPLES_PER_PACKET[format];
+			device->concealMode = concealMode;
+			device->filterSettings = filterSettings;
+			device->referenceMode = referenceMode;
+			device->referenceMask = referenceMask;
+			device->spikeSettings = spikeSettings;
+			device->ttlDebounceMs = ttlDebounceMs;
+
+			// aggregator devices run at the editor's desired sample rate, actual rate depends on their channel count
+			device->bitrate = bitrate;
+			device->sampleRate = desiredSampleRate > 0 ? updateSampleRate(numChannels, device->bitrate) : sample_rate;
+		}
+	}
+
+	// keep device 0, replace the rest
+	while (rcbDevices.size() > 1)
+		rcbDevices.removeLast();
 
-}
+	while (extraDevices.size() > 0)
+		rcbDevices.add(extraDevices.removeAndReturn(0));
 
-String RcbWifi::handleConfigMessage(String msg)
-{
-	return "";
+	// new devices need init before they stream
+	initPassed = false;
+
+	LOGC("[dspw] RCB aggregator devices = ", getExtraDevices());
+	return getExtraDevices();
 }
 
 void RcbWifi::resizeBuffers()
 {
     LOGD( "[dspw] In Resize Buffers()");
-    if (auxEnableState == true)
-    {
-        sourceBuffers[0]->resize(num_channels + 3, 10000);  // with aux
-        convBufSize = 0 + (((num_channels + 3)*num_samp) * 4);  // with aux
-        
-    } else
-    {
-        sourceBuffers[0]->resize(num_channels, 10000);  // no aux
-        convBufSize = 0 + (((num_channels)*num_samp) * 4); //no aux
-    }
-    
-	recvBufSize = 40 + (((num_channels + 2) * num_samp) * 2);
-    
-	recvbuf = (uint16_t*)realloc(recvbuf, recvBufSize);
-    convbuf = (float*)realloc(convbuf, convBufSize);
-	auxbuf = (uint16_t*)realloc(auxbuf,  num_samp * 8);
-    
-    LOGD("[dspw] num_channels = ",String(num_channels));
-    LOGD( "[dspw] num_samp = ",String(num_samp));
-    LOGD("[dspw] resize recBufSize = ",String(recvBufSize));
-    LOGD("[dspw] resize convBufSize = ",String(convBufSize));
+	updatePrimaryDevice();
+	buffersAllocated = true;
+
+	// one DataBuffer per device stream, then one per aux stream and one per LFP stream, in the order updateSettings() publishes them
+	const int numDevices = rcbDevices.size();
+	const int auxFirst = numDevices;
+	const int lfpFirst = auxEnableState ? 2 * numDevices : numDevices;
+	const int numBuffers = lfpRate > 0 ? lfpFirst + numDevices : lfpFirst;
 
-	sampleNumbers.resize(num_samp);
-	timestamps.clear();
-	timestamps.insertMultiple(0, 0.0, num_samp);
-	ttlEventWords.resize(num_samp);
+	while (sourceBuffers.size() < numBuffers)
+		sourceBuffers.add(new DataBuffer(num_channels, DATA_BUFFER_SIZE));
+
+	while (sourceBuffers.size() > numBuffers)
+		sourceBuffers.removeLast();
+
+	for (int d = 0; d < numDevices; d++)
+	{
+		RcbDevice* device = rcbDevices[d];
+
+		sourceBuffers[d]->resize(device->numChannels, DATA_BUFFER_SIZE);
+
+		DataBuffer* auxBuffer = nullptr;
+		DataBuffer* lfpBuffer = nullptr;
+		device->lfpFactor = getLfpFactor(device);
+
+		if (auxEnableState == true)
+		{
+			auxBuffer = sourceBuffers[auxFirst + d];
+			auxBuffer->resize(RCB_NUM_AUX_CHANNELS, DATA_BUFFER_SIZE);
+		}
+
+		if (lfpRate > 0)
+		{
+			lfpBuffer = sourceBuffers[lfpFirst + d];
+			lfpBuffer->resize(device->numChannels, DATA_BUFFER_SIZE);
+		}
+
+		if (!device->resizeBuffers(sourceBuffers[d], auxBuffer, lfpBuffer, data_scale, data_offset))
+			buffersAllocated = false;
+		applyReorderWindow(device);
+
+		LOGD("[dspw] device ", d, " num_channels = ", String(device->numChannels));
+		LOGD("[dspw] device ", d, " num_samp = ", String(device->numSamples));
+	}
 }
 
 void RcbWifi::updateSettings(OwnedArray<ContinuousChannel>* continuousChannels,
@@ -149,72 +1230,137 @@ void RcbWifi::updateSettings(OwnedArray<ContinuousChannel>* continuousChannels,
 	
 	//channelNames.clear();  ??
 
-	DataStream::Settings dataStreamSettings
+	updatePrimaryDevice();
+
+	for (int d = 0; d < rcbDevices.size(); d++)
 	{
-		"RCBWifiStream",
-		"Data acquired via RCB UDP network stream",  // "description"
-		"rcbwifi.data",  // "identifier"
+		RcbDevice* device = rcbDevices[d];
+
+		DataStream::Settings dataStreamSettings
+		{
+			d == 0 ? String("RCBWifiStream") : "RCBWifiStream" + String(d + 1),
+			"Data acquired via RCB UDP network stream " + device->ipNumStr,  // "description"
+			"rcbwifi.data",  // "identifier"
 
-		sample_rate
+			device->sampleRate
 
-	};
+		};
 
-	LOGD("[dspw] updateSettings num_channels = ",String(num_channels));
+		LOGD("[dspw] updateSettings num_channels = ",String(device->numChannels));
     
-	DataStream* stream = new DataStream(dataStreamSettings);
-	sourceStreams->add(stream);
+		DataStream* stream = new DataStream(dataStreamSettings);
+		sourceStreams->add(stream);
+
+		for (int ch = 0; ch < device->numChannels; ch++)
+		{
+			ContinuousChannel::Settings channelSettings{
+				ContinuousChannel::Type::ELECTRODE,
+				"CH" + String(ch + 1),
+				"Channel acquired via RCB UDP network stream",  // "description"
+				"rcbwifi.continuous",  // "identifier"
+
+				data_scale, //0.195
+
+				stream
+				
+			};
 
-	for (int ch = 0; ch < num_channels; ch++)
+			continuousChannels->add(new ContinuousChannel(channelSettings));
+			continuousChannels->getLast()->setUnits("uV");
+		}
+
+		EventChannel::Settings eventSettings{
+			   EventChannel::Type::TTL,
+			   "Events",
+			   "description",
+			   "identifier",
+			   stream,
+			   // digital inputs and the concealed samples line, then with detection on one spike line per channel.
+			   // a DataThread can only push samples and TTL words, so spikes are published as these lines only
+			   spikeSettings.enabled ? RCB_TTL_SPIKE_FIRST_LINE + device->numChannels : RCB_NUM_TTL_LINES
+		};
+
+		eventChannels->add(new EventChannel(eventSettings));
+	}
+
+	// aux streams after all the device streams, then the LFP streams. sourceBuffers are in the same order
+	for (int d = 0; auxEnableState && d < rcbDevices.size(); d++)
 	{
-		ContinuousChannel::Settings channelSettings{
-			ContinuousChannel::Type::ELECTRODE,
-			"CH" + String(ch + 1),
-			"Channel acquired via RCB UDP network stream",  // "description"
-			"rcbwifi.continuous",  // "identifier"
+		RcbDevice* device = rcbDevices[d];
 
-			data_scale, //0.195
+		DataStream::Settings dataStreamSettings
+		{
+			d == 0 ? String("RCBWifiAux") : "RCBWifiAux" + String(d + 1),
+			"Aux inputs of RCB UDP network stream " + device->ipNumStr,  // "description"
+			"rcbwifi.aux",  // "identifier"
+
+			device->sampleRate / RCB_AUX_PHASES
 
-			stream
-			
 		};
 
-		continuousChannels->add(new ContinuousChannel(channelSettings));
-		continuousChannels->getLast()->setUnits("uV");
+		DataStream* stream = new DataStream(dataStreamSettings);
+		sourceStreams->add(stream);
+
+		for (int ch = 0; ch < RCB_NUM_AUX_CHANNELS; ch++)
+		{
+			ContinuousChannel::Settings channelSettings{
+				ContinuousChannel::AUX,
+				"_AUX" + String(ch + 1),
+				"Aux input channel RCB UDP network stream",
+				"rcbwifi.continuous.aux",
+
+				RCB_AUX_SCALE,
+
+				stream
+			};
+			continuousChannels->add(new ContinuousChannel(channelSettings));
+			continuousChannels->getLast()->setUnits("mV");
+		}
 	}
 
-    if (auxEnableState == true)
-    {
-        for (int ch = 0; ch < 3; ch++)
-        {
-            ContinuousChannel::Settings channelSettings{
-                ContinuousChannel::AUX,
-                "_AUX" + String(ch + 1),
-                "Aux input channel RCB UDP network stream",
-                "rcbwifi.continuous.aux",
-                
-                0.0000374,
-                
-                stream
-            };
-            continuousChannels->add(new ContinuousChannel(channelSettings));
-            continuousChannels->getLast()->setUnits("mV");
-        }
-    }
+	for (int d = 0; lfpRate > 0 && d < rcbDevices.size(); d++)
+	{
+		RcbDevice* device = rcbDevices[d];
 
-	EventChannel::Settings eventSettings{
-		   EventChannel::Type::TTL,
-		   "Events",
-		   "description",
-		   "identifier",
-		   sourceStreams->getFirst(),//  getFirst(),
-		   8  // max number of events want to use
-	};
+		DataStream::Settings dataStreamSettings
+		{
+			d == 0 ? String("RCBWifiLFP") : "RCBWifiLFP" + String(d + 1),
+			"Low-pass decimated RCB UDP network stream " + device->ipNumStr,  // "description"
+			"rcbwifi.lfp",  // "identifier"
+
+			device->sampleRate / getLfpFactor(device)
+
+		};
 
-	eventChannels->add(new EventChannel(eventSettings));
+		DataStream* stream = new DataStream(dataStreamSettings);
+		sourceStreams->add(stream);
+
+		for (int ch = 0; ch < device->numChannels; ch++)
+		{
+			ContinuousChannel::Settings channelSettings{
+				ContinuousChannel::Type::ELECTRODE,
+				"LFP" + String(ch + 1),
+				"Low-pass decimated channel acquired via RCB UDP network stream",  // "description"
+				"rcbwifi.continuous.lfp",  // "identifier"
+
+				data_scale,
+
+				stream
+
+			};
+
+			continuousChannels->add(new ContinuousChannel(channelSettings));
+			continuousChannels->getLast()->setUnits("uV");
+		}
+	}
 }
 
 bool RcbWifi::foundInputSource()
 {
+	// a replay needs no RCB
+	if (replayPath.isNotEmpty())
+		return true;
+
 	if (initPassed == true)
 	{
 		if (connected == 0)
@@ -229,25 +1375,15 @@ bool RcbWifi::foundInputSource()
 
 void  RcbWifi::tryToConnect()
 {
-    // if socket is open, shut it down and start fresh
-    if (socket != nullptr)
-	{
-        LOGD("[dspw] socket is not null");
-		socket->shutdown();
-        socket.reset();
-	}
+	updatePrimaryDevice();
 
-    socket = std::make_unique<DatagramSocket>();
-	socket->setEnablePortReuse(true);
-	bool bound = socket->bindToPort(port);
-	connected = bound;  // this needs more cleanup and thought
+	// bind every device socket, starting fresh
+	connected = true;
 
-	if (bound)
+	for (auto device : rcbDevices)
 	{
-        LOGC("[dspw] Socket bound to port ",port);
-	}
-	else {
-        LOGC("[dspw] Could not bind socket to port ",port);
+		if (!device->connect())
+			connected = false;  // this needs more cleanup and thought
 	}
 }
 
@@ -257,19 +1393,26 @@ bool RcbWifi::startAcquisition()
     String myTime = Time::getCurrentTime().toString(false,true);
     LOGC("[dspw] Start Time = ",myTime);
     
+	dataThreadScheduled = false;
+	dataThreadSpin.reset();
+
+	if (!buffersAllocated)
+	{
+		LOGC("[dspw] RCB WiFi : not starting, the sample buffers could not be allocated");
+		return false;
+	}
+
+	if (replayPath.isNotEmpty())
+		return startReplay();
+
 	LOGC("[dspw] StartAcq batteryInit =  ",batteryInit);
 	if (initPassed == true && (batteryInit > BATT_INIT_THRESH - 0.25)) // and batt poll is > ?
 	{
-		sourceBuffers[0]->clear();  //macos
-		firstPacket = 1;
-		hit = 0;
-		miss = 0;
-		delayed = 0;
-  
-		total_samples = 0;  // reset sampleNumbers used in updateBuffer()
-		eventState = 0;  // reset TTL event state
-	
-		startThread();
+		for (auto buffer : sourceBuffers)
+			buffer->clear();  //macos
+
+		for (auto device : rcbDevices)
+			device->resetCounters();
 
 		//should already be connected but in case needed
 		if (connected == 0)
@@ -277,12 +1420,42 @@ bool RcbWifi::startAcquisition()
 			tryToConnect();
 		}
 
+		// one socket reader thread fills the packet rings of all devices, DataThread converts from them
+		receiver = std::make_unique<RcbReceiver>();
+		receiver->setScheduling(threadPriority, receiverCpu);
+		receiver->setLowLatency(lowLatency);
+
+		for (auto device : rcbDevices)
+		{
+			// room for WiFi bursts while the reader thread is held up
+			device->receiveBufferBytes = RcbWifiNode::setReceiveBufferSize(device->socket.get(), receiveBufferKB * 1024);
+			LOGC("[dspw] port-", String(device->port), "  socket receive buffer = ", device->receiveBufferBytes / 1024, " kB");
+
+			// also set back to 0 when low latency was turned off, the socket outlives the acquisition
+			device->busyPollUs = setBusyPoll(device->socket.get(), lowLatency ? RCB_BUSY_POLL_US : 0);
+
+			receiver->addSource(device->socket.get(), device->port, &device->packetRing, &device->telemetry.socketQueueBytes);
+		}
+
+		if (capturePath.isNotEmpty())
+		{
+			startCapture();
+			receiver->setCapture(capture.get());
+		}
+
+		receiver->startThread();
+
+		startThread();
+
 		// add check for connected before start UDP data stream
 		if (connected == true)
 		{
-			// send HTTP Post message to RCB - RUN
-			LOGC("[dspw] Start Wifi UDP Stream.  ",ipNumStr);
-			sendRCBTriggerPost(ipNumStr, "__SL_P_ULD=ON");
+			// send HTTP Post message to RCBs - RUN
+			for (auto device : rcbDevices)
+			{
+				LOGC("[dspw] Start Wifi UDP Stream.  ", device->ipNumStr);
+				sendRCBTriggerPost(device->ipNumStr, "__SL_P_ULD=ON");
+			}
 
 			return true;
 		}
@@ -304,8 +1477,11 @@ bool RcbWifi::startAcquisition()
 
 bool RcbWifi::stopAcquisition()
 {
-	seqNum = 0;
-	firstPacket = 1;
+	for (auto device : rcbDevices)
+	{
+		device->seqNum = 0;
+		device->firstPacket = 1;
+	}
     String myTime = Time::getCurrentTime().toString(false,true);
     LOGC("[dspw] Stop Time = ",myTime);
     
@@ -316,9 +1492,10 @@ bool RcbWifi::stopAcquisition()
         LOGD( "[dspw] thread should exit");
 	}
 
-    if (initPassed == true)
+    if (initPassed == true && replay == nullptr)
     {
-        sendRCBTriggerPost(ipNumStr, "__SL_P_ULD=OFF");
+		for (auto device : rcbDevices)
+			sendRCBTriggerPost(device->ipNumStr, "__SL_P_ULD=OFF");
     }
     
 	if (waitForThreadToExit(1000))
@@ -330,213 +1507,181 @@ bool RcbWifi::stopAcquisition()
 		LOGD("[dspw] RCB WiFi data thread failed to exit, continuing anyway...");
 	}
 
+	// what the streaming path queued since the last editor update
+	flushLogs();
+
+	if (receiver != nullptr)
+	{
+		receiver->stopThread(1000);  // also before socket shutdown
+
+		const ScopedLock sl(schedulingLock);
+		receiverSchedulingInfo = receiver->getSchedulingInfo();
+		receiver.reset();
+	}
+
+	if (replay != nullptr)
+	{
+		replay->stopThread(1000);
+		LOGC("[dspw] RCB replay ", getReplayInfo());
+		replay.reset();
+	}
+
+	if (capture != nullptr)
+	{
+		capture->close();
+		LOGC("[dspw] RCB capture ", getCaptureInfo());
+	}
+
+	for (auto device : rcbDevices)
+		LOGC("[dspw] port-", String(device->port), "  reorder depth ", device->getReorderStats());
+
+	LOGC("[dspw] RCB clocks ", getClockInfo());
+
 	if (connected == true)
 	{
-        socket->shutdown(); // important to be after stopping thread
+		for (auto device : rcbDevices)
+			device->disconnect(); // important to be after stopping thread
         connected = false;
 	}
 	
-	sourceBuffers[0]->clear();
+	for (auto buffer : sourceBuffers)
+		buffer->clear();
 
 	return true;
 }
 
 bool RcbWifi::updateBuffer()
 {
-	int rc = socket->read(recvbuf, recvBufSize, true); //1444 1468
+	int numPackets = 0;
+	bool packetsOk = true;
 
-	if (rc == -1)
-    {
-		LOGD("[dspw] RCB WiFi : Data shape mismatch ");
-		LOGD("[dspw] updateBuffer recBufSize = ",String(recvBufSize));
-		LOGD("[dspw] updateBuffer convBufSize = ",String(convBufSize));
-		return false;
+	if (!dataThreadScheduled)
+	{
+		// the DataThread is a new thread each acquisition, so it sets itself up on its first call
+		String info = applyThreadScheduling(threadPriority, RCB_FIFO_PRIORITY_DATATHREAD, dataThreadCpu);
+		LOGC("[dspw] RCB WiFi DataThread: ", info);
+
+		const ScopedLock sl(schedulingLock);
+		dataThreadSchedulingInfo = info;
+		dataThreadScheduled = true;
 	}
 
-    magicNum = (uint8_t)(recvbuf[0] & 0x00ff);
-    // LOGD("[dspw] mNum = ",(String::toHexString(magicNum)));
-	//uint16_t sod = (recvbuf[0]);// &0x00ff);
-    sod = (recvbuf[0]);// &0x00ff);
-	
-	if (magicNum == 0xc5) // is a good packet
-	{
-		seqNum = ((uint32_t)recvbuf[5] << 16) + recvbuf[4];
-		auxMask = (uint8_t)(recvbuf[16] & 0x00ff);
-		auxPhase = (uint8_t)(recvbuf[16] >> 8);
-		batteryVolts = recvbuf[18]; // battery voltage
-		//uint16_t digInputs = recvbuf[19];  // state of digital inputs.  connect to OE TTL Events
-        digInputs = recvbuf[19];  // state of digital inputs.  connect to OE TTL Events
+	// convert whatever each device has waiting and push it to that device's stream
+	for (int d = 0; d < rcbDevices.size(); d++)
+		numPackets += rcbDevices[d]->processPackets(packetsOk);
 
-		int auxStart = auxPhase;
+	if (numPackets == 0)
+	{
+		Thread* source = replay != nullptr ? (Thread*)replay.get() : (Thread*)receiver.get();
 
-		if (firstPacket == 1)
+		if (source == nullptr || !source->isThreadRunning())
 		{
-            // might need to indicate to user and stop acq if packet containing seqnum = 1 is lost
-            // however does not happen in testing.
-			if (seqNum == 1)
+			// the last packets may have been published after the rings were read above
+			for (auto device : rcbDevices)
 			{
-				LOGC("[dspw] UDP Port - ",String(port),"  First seqNum = ",(String::toHexString(seqNum)));
-				firstPacket = 0;
+				if (device->packetRing.getNumReady() > 0)
+					return packetsOk;
 			}
 
-			nextsn = seqNum;
-			hit = 0; //macos
-			miss = 0;
-			delayed = 0;
-            
-            LOGD("[dspw] mNum = ",(String::toHexString(magicNum)));
-			LOGD("[dspw] sod = ",(String::toHexString(sod)));
-			LOGD("[dspw] port-",String(port),"  seqNum = ",(String::toHexString(seqNum)));
-		}
-
-		if (nextsn == 0 || seqNum == nextsn) {
-			nextsn = seqNum + 1;
-			hit++;
-		}
-		else if (seqNum < nextsn) {
-			delayed++;
-			nextsn = seqNum + 1; // macos
-			LOGD("[dspw] port-",String(port),"  delayed seqNum = ",(String::toHexString(seqNum)));
-		}
-		else {
-			miss += seqNum - nextsn;
-			nextsn = seqNum + 1;
-			hit++;
-            //should mark data samples as missed?
+			LOGD(replay != nullptr ? "[dspw] RCB WiFi : replay finished " : "[dspw] RCB WiFi : socket reader thread stopped ");
+			return threadShouldExit();  // false stops acquisition if a socket failed while streaming
 		}
 
-		// using the transpose version from EphysSocket
-		int k = 0;
-		for (int i = 0; i < num_samp; i++)
+		if (lowLatency)
 		{
-			for (int j = 0; j < num_channels; j++)
-			{
-				convbuf[k++] = 0.195 * (float)(recvbuf[(j + 22) + (i * (num_channels + 2))] - 32768);
-			}
-
-            if (auxEnableState == true)
-            {
-                //collect aux into buffer
-                int auxIndex = auxStart % 4;
-               
-                // in RCB packet aux samples are located before electrode samples.
-                auxbuf[auxIndex] = recvbuf[(20) + (i * (num_channels + 2))] - 32768;
-                auxStart = auxStart + 1;
-                
-                for (int j = 0; j < 3; j++)
-                {
-                    convbuf[k++] = 0.0000374 * (float)auxbuf[j + 1];
-                }
-            }
-
-			sampleNumbers.set(i, total_samples + i);
-			ttlEventWords.set(i, eventState);
-
-			eventState = digInputs;
-
-			/* OE Josh test code to toggle TTL events
-			if ((total_samples + i) % 15000 == 0)
-			{
-				if (eventState == 0)
-					eventState = 0xf;// each eventstate bit corresponds to an event 0x1 = event 1, 0xf = event 1,2,3,4
-				else
-					eventState = 0;
-			}
-			*/
+			// busy poll the packet rings, the next packet is picked up as soon as it is published
+			dataThreadSpin.pause();
+			return packetsOk;
 		}
-		sourceBuffers[0]->addToBuffer(convbuf,
-			sampleNumbers.getRawDataPointer(),
-			timestamps.getRawDataPointer(),
-			ttlEventWords.getRawDataPointer(),
-			num_samp,
-			1);
 
-		// mult by seqNum. if seqnum increment in packet is more than one then packets have been lost
-		total_samples = (int64)num_samp * seqNum;
-
-		return true;
+		// wait for the socket reader or replay thread, with a timeout so threadShouldExit() is still seen
+		(replay != nullptr ? replay->dataReady : receiver->dataReady).wait(100);
 	}
-	LOGC("[dspw] RCB WiFi : Fail Packet MagicNum test. ");
-	return false;
+	else
+	{
+		dataThreadSpin.reset();
+	}
+
+	return packetsOk;
 }
 
-void RcbWifi::sendRCBTriggerPost(String ipNumStr, String msgStr)
+void RcbWifi::sendRCBTriggerPost(String ipNumStr, String msgStr, std::function<void(bool)> done)
 {
-    initPassed = false;
-	this->ipNumStr = ipNumStr;
-	//URL urlPost("http://192.168.0.93");
-	//URL urlPost("http://" + ipNumStr);  // only works with macOs and windows
-    //urlPost = urlPost.withPOSTData(msgStr); // only works with macOs and windows
-    URL urlPost = URL("http://" + ipNumStr).withPOSTData(msgStr);  //this approach needed for linux
-    
-	int statusCode = 0;
-	
     //LOGD("POST ipNumStr - ", ipNumStr);
     //LOGD("POST msgStr - ", msgStr);
-    LOGD("[dspw] POST str URL - ", urlPost.toString(true));
-    LOGD("[dspw] POST str data - ", urlPost.getPostData());
-	std::unique_ptr<InputStream> postStream(urlPost.createInputStream(true, nullptr, nullptr, String(), 2000, &responseHeaders, &statusCode, 5, "POST"));
-    
-	if (postStream != nullptr)
-    {
-        initPassed = true;
-		String postStr = postStream->readEntireStreamAsString();
-        LOGD("[dspw] PostStream StatusCode = ",statusCode);
-        if (statusCode != 204)
-        LOGD("[dspw] Post Stream = ",postStr);
-	}
-	else
+    LOGD("[dspw] POST str URL - ", "http://" + ipNumStr);
+    LOGD("[dspw] POST str data - ", msgStr);
+
+	// queued, the response comes back on the message thread
+	control->post(ipNumStr, msgStr, [this, ipNumStr, done](const RcbResponse& response)
 	{
-		initPassed = false;
-		AlertWindow::showMessageBox(AlertWindow::NoIcon,
-			"RCB-LVDS Module not found at IP address " + ipNumStr,
-			"Please check your IP address setting. \r\n\r\n"
-			"Press Initialize button to try again.",
-			"OK", 0);
-	}
+		if (response.ok)
+		{
+			LOGD("[dspw] PostStream StatusCode = ", response.statusCode, "  ", String(response.roundTripMs, 1), " ms");
+			if (response.statusCode != 204)
+				LOGD("[dspw] Post Stream = ", response.text);
+		}
+		else if (done == nullptr)
+		{
+			initPassed = false;
+			AlertWindow::showMessageBoxAsync(AlertWindow::NoIcon,
+				"RCB-LVDS Module not found at IP address " + ipNumStr,
+				"Please check your IP address setting. \r\n\r\n"
+				"Press Initialize button to try again.",
+				"OK");
+		}
+
+		if (done != nullptr)
+			done(response.ok);
+	});
 }
 
-void RcbWifi::setRCBTokens()
+StringArray RcbWifi::getDeviceTokens(const String& hostStr, int numChannels, int chStart, uint32_t spiBitrate, float sampleRate)
 {
-	// only called from Init Button
+	// builds the full init sequence for one RCB, see setRCBTokens()
+	StringArray tokens;
+
 	// now that we have good RCB WiFi and good Intan, send multiple initialization http post messages to RCB WiFi Module
 	// some values are sent from editor, ex. rhdNumTsItems
 
+	// mux and adc bias depend on this RCB's actual sample rate
+	getMuxAdcBias(sampleRate);
+
 	// send HTTP Post message to RCB - 
 	//Init host ip and port 192.168.0.102:4416
     // sendRCBTriggerPost(ipNumStr, "__SL_P_UUU=192.168.0.102:4416");
-	rcbMsgStr = "__SL_P_UUU=" + myHostStr;
-	LOGD("[dspw] Host is  ",myHostStr);
+	rcbMsgStr = "__SL_P_UUU=" + hostStr;
+	LOGD("[dspw] Host is  ",hostStr);
     LOGD("[dspw] Msg is  ",rcbMsgStr);
-    sendRCBTriggerPost(ipNumStr, rcbMsgStr);
+    tokens.add(rcbMsgStr);
 
 	// send HTTP Post message to RCB - 
 	//set RCB WiFi Power Amp value
 	rcbMsgStr = "__SL_P_UPA=" + rcbPaStr;
     LOGD("[dspw] RCB PA =  ",rcbPaStr);
-	sendRCBTriggerPost(ipNumStr, rcbMsgStr);
+	tokens.add(rcbMsgStr);
 
 	// get number of channels from global
     // set rhd channel mask
-	//String rhdChMaskStr = (chMask[num_channels - 1]) + " 6"; //the "6" is needed in all masks for correct aux sequence
+	//String rhdChMaskStr = (chMask[numChannels - 1]) + " 6"; //the "6" is needed in all masks for correct aux sequence
     //LOGC("[dspw] rhdChMaskStr -  ",rhdChMaskStr);
     
-    String rhdChMaskShftStr = String::toHexString(chShftMask[num_channels - 1] << (chShift - 1)) + " 6" ; //the "6" is needed in all masks for correct aux sequence
+    String rhdChMaskShftStr = String::toHexString(chShftMask[numChannels - 1] << (chStart - 1)) + " 6" ; //the "6" is needed in all masks for correct aux sequence
    
-    //LOGD("[dspw] ChMaskShft -  ",chShift);
+    //LOGD("[dspw] ChMaskShft -  ",chStart);
     LOGC("[dspw] rhdChMaskShftStr -  ",rhdChMaskShftStr.toUpperCase());
 
     rcbMsgStr = "__SL_P_U00=" + rhdChMaskShftStr.toUpperCase();
     LOGD("[dspw] rcbMsgStr with Shift  -  ",rcbMsgStr);
-	sendRCBTriggerPost(ipNumStr, rcbMsgStr);
+	tokens.add(rcbMsgStr);
 
 	// send SPI Bit Rate command to RCB
 	//uint32_t bitrate = 4e7 / divider;   // actual spi clk rate that is sent to RCB
 	//LOGD("[dspw] SPI bitrate -  ",bitrate);
-	String bitRateStr = String(bitrate);
+	String bitRateStr = String(spiBitrate);
 	rcbMsgStr = "__SL_P_URB=" + bitRateStr;
 	LOGD("[dspw] SPI bitRateStr -  ",bitRateStr);
-	sendRCBTriggerPost(ipNumStr, rcbMsgStr);
+	tokens.add(rcbMsgStr);
 
 	// Set RHD filter Regs rhdReg08 thru rhdReg13
 	// get up/low BW
@@ -558,7 +1703,7 @@ void RcbWifi::setRCBTokens()
 	LOGD("[dspw] rhdLowBwInt -  ",rhdLowBwInt);
 
 	// set RHD Amp power to agree with channel mask.  include channel start shift
-    int rhdPaMask = (chShftMask[num_channels - 1] << (chShift - 1));
+    int rhdPaMask = (chShftMask[numChannels - 1] << (chStart - 1));
     LOGD("[dspw] rhdPaMask -  ", String::toHexString(rhdPaMask));
     
 	rhdReg14 = (rhdPaMask & 0x000000ff);
@@ -577,15 +1722,133 @@ void RcbWifi::setRCBTokens()
 	String rhdRegAll = buffer;
     LOGD("[dspw] RHD Reg Init Values - ",rhdRegAll);
 	rcbMsgStr = "__SL_P_UII=" + rhdRegAll;
-	sendRCBTriggerPost(ipNumStr, rcbMsgStr);
-    
-    // if we get this far then try to connect to host UDP socket port
-    // possible that user has changed port number so must re-connect
-        tryToConnect();
-        LOGD("[dspw] RCB Tokens Connected = ",connected);
+	tokens.add(rcbMsgStr);
+
+	return tokens;
+}
+
+void RcbWifi::setRCBTokens(std::function<void(bool)> done)
+{
+	// only called from Init Button
+	// the tokens of each RCB go out in order, different RCBs are initialized in parallel
+	updatePrimaryDevice();
+
+	auto numPending = std::make_shared<int>(0);
+	auto failedIps = std::make_shared<StringArray>();
+
+	auto tokensAnswered = [this, failedIps, done]
+	{
+		// every token has been answered
+		initPassed = failedIps->isEmpty();
+
+		if (!initPassed)
+		{
+			AlertWindow::showMessageBoxAsync(AlertWindow::NoIcon,
+				"RCB-LVDS Module not found at IP address " + failedIps->joinIntoString(", "),
+				"Please check your IP address setting. \r\n\r\n"
+				"Press Initialize button to try again.",
+				"OK");
+		}
+
+		// if we get this far then try to connect to host UDP socket port
+		// possible that user has changed port number so must re-connect
+		tryToConnect();
+		LOGD("[dspw] RCB Tokens Connected = ",connected);
+
+		if (done != nullptr)
+			done(initPassed);
+	};
+
+	// aggregator devices stream to the same host, each on its own port
+	String hostIpStr = myHostStr.upToFirstOccurrenceOf(":", false, false);
+
+	for (int d = 0; d < rcbDevices.size(); d++)
+	{
+		RcbDevice* device = rcbDevices[d];
+		StringArray tokens;
+
+		if (d == 0)
+		{
+			tokens = getDeviceTokens(myHostStr, num_channels, chShift, bitrate, sample_rate);
+		}
+		else
+		{
+			device->sampleRate = updateSampleRate(device->numChannels, device->bitrate);
+			tokens = getDeviceTokens(hostIpStr + ":" + String(device->port), device->numChannels, device->chShift, device->bitrate, device->sampleRate);
+		}
+
+		String rcbIpStr = device->ipNumStr;
+		StringArray changed = getChangedTokens(rcbIpStr, tokens);
+
+		lastInitSent.set(rcbIpStr, String(changed.size()) + " of " + String(tokens.size()));
+		LOGC("[dspw] RCB ", rcbIpStr, " init tokens sent ", lastInitSent[rcbIpStr]);
+
+		if (initMode == RcbInitMode::COMBINED && changed.size() > 1)
+			changed = StringArray(changed.joinIntoString("&"));
+
+		*numPending += changed.size();
+
+		for (auto token : changed)
+		{
+			sendRCBTriggerPost(rcbIpStr, token, [this, rcbIpStr, token, numPending, failedIps, tokensAnswered](bool ok)
+			{
+				if (ok)
+				{
+					setAppliedTokens(rcbIpStr, token);
+				}
+				else
+				{
+					failedIps->addIfNotAlreadyThere(rcbIpStr);
+					appliedTokens.erase(rcbIpStr);
+				}
+
+				if (--(*numPending) == 0)
+					tokensAnswered();
+			});
+		}
+	}
+
+	// every RCB is already set up this way
+	if (*numPending == 0)
+		tokensAnswered();
+
+	// rhd bias regs are shared, leave them set for the editor's device
+	getMuxAdcBias(sample_rate);
+}
+
+StringArray RcbWifi::getChangedTokens(const String& rcbIpStr, const StringArray& tokens)
+{
+	if (initMode == RcbInitMode::FULL || appliedTokens.count(rcbIpStr) == 0)
+		return tokens;
+
+	const StringPairArray& applied = appliedTokens[rcbIpStr];
+	StringArray changed;
+
+	for (auto token : tokens)
+	{
+		String name = token.upToFirstOccurrenceOf("=", false, false);
+
+		if (!applied.containsKey(name) || applied[name] != token.fromFirstOccurrenceOf("=", false, false))
+			changed.add(token);
+	}
+
+	return changed;
+}
+
+void RcbWifi::setAppliedTokens(const String& rcbIpStr, const String& tokens)
+{
+	StringPairArray& applied = appliedTokens[rcbIpStr];
+
+	for (auto token : StringArray::fromTokens(tokens, "&", ""))
+		applied.set(token.upToFirstOccurrenceOf("=", false, false), token.fromFirstOccurrenceOf("=", false, false));
 }
 
 float RcbWifi::updateSampleRate()
+{
+	return updateSampleRate(num_channels, bitrate);
+}
+
+float RcbWifi::updateSampleRate(int numChannels, uint32_t& spiBitrate)
 {
 	// called from init
 	// calc the actual sample rate using desisired sample rate and num channels
@@ -599,7 +1862,7 @@ float RcbWifi::updateSampleRate()
 
 	// get number of channels from dropdown box
 	// now done in init before updateSampleRate() is called
-	numChannelsEnabled = num_channels;
+	numChannelsEnabled = numChannels;
 
 	// get desired sample rate from dropdown box
 	// now done in init before updateSampleRate() is called
@@ -612,18 +1875,18 @@ float RcbWifi::updateSampleRate()
 	if (divider < 2) divider = 2;
     LOGD("[dspw] divider -  ",divider);
 
-	bitrate = 4e7 / divider;         // actual spi clk rate that is sent to RCB
-	LOGD("[dspw] SPI bitrate -  ",bitrate);
+	spiBitrate = 4e7 / divider;         // actual spi clk rate that is sent to RCB
+	LOGD("[dspw] SPI bitrate -  ",spiBitrate);
 
 	double Ts;
 	if (0 == (divider & 1))
 	{   // clock divider is even, use 200ns delay
-		Ts = numChannelsEnabled * (200e-9 + 16.5 / bitrate);   // actual sample period
+		Ts = numChannelsEnabled * (200e-9 + 16.5 / spiBitrate);   // actual sample period
 		LOGD("[dspw] Ts even -  ",Ts);
 	}
 	else
 	{// clock divider is odd, use 187.5ns delay
-		Ts = numChannelsEnabled * (187.5e-9 + 16.5 / bitrate);   // actual sample period
+		Ts = numChannelsEnabled * (187.5e-9 + 16.5 / spiBitrate);   // actual sample period
         LOGD("[dspw] Ts odd -  ",Ts);
 	}
 
@@ -735,19 +1998,32 @@ int adcBufferBias = 2;
     LOGD("[dspw] adcBufferBias =  ",adcBufferBias);
 }
 
-String RcbWifi::getIntanStatusInfo()
+void RcbWifi::requestIntanStatus(std::function<void(String)> done)
 {
-	isGoodIntan = false;
-	isGoodRCB = false;
-
     String myTime = Time::getCurrentTime().toString(false,true);
     LOGD("[dspw] Time = ",myTime);
     
 	// URL urlInit("http://192.168.0.93/intan_status.html");
-	URL urlInit("http://" + ipNumStr + "/intan_status.html");  
+	// access RCB module embedded webpage, the page is parsed on the message thread when it arrives
+	control->get(ipNumStr, "/intan_status.html", [this, done](const RcbResponse& response)
+	{
+		String htmlStatus = getIntanStatusInfo(response.text);
+		LOGD("[dspw] RCB status ", String(response.roundTripMs, 1), " ms");
+
+		// the RCB may have been power cycled while out of reach, send it everything next init
+		if (!isGoodRCB)
+			appliedTokens.erase(ipNumStr);
+
+		if (done != nullptr)
+			done(htmlStatus);
+	});
+}
+
+String RcbWifi::getIntanStatusInfo(const String& result)
+{
+	isGoodIntan = false;
+	isGoodRCB = false;
 
-	// access RCB module embedded webpage. 
-	auto result = getResultText(urlInit);
 	//LOGD("[dspw] msg is  ",result);
 	if (result.length() > 20)
 	{
@@ -781,11 +2057,11 @@ String RcbWifi::getIntanStatusInfo()
                 batteryStatusInfo = ("Bat " + String(batteryInit, 2) + "V Fail");
                 isGoodRCB = false;
                 LOGC("[dspw] RCB Init Fail Battery Voltage =  ", batteryInit, "V");
-                AlertWindow::showMessageBox(AlertWindow::NoIcon,
+                AlertWindow::showMessageBoxAsync(AlertWindow::NoIcon,
                     "RCB " + ipNumStr + " Battery voltage is too low.",
                     "Please recharge or change battery. \r\n\r\n"
                     "Press Initialize button to try again.",
-                    "OK", 0);
+                    "OK");
                 
                 return "RCB battery needs recharge.";
             }
@@ -822,11 +2098,11 @@ String RcbWifi::getIntanStatusInfo()
 					if (maxNumCh > num_channels)
 					{
 						isGoodIntan = false;
-						AlertWindow::showMessageBox(AlertWindow::NoIcon,
+						AlertWindow::showMessageBoxAsync(AlertWindow::NoIcon,
 							"Number of channels mismatch.",
 							"Please check that Channel setting is not greater than Headstage Max channels. \r\n\r\n"
 							"Press Initialize button to try again.",
-							"OK", 0);
+							"OK");
 					}
 				}
 
@@ -882,14 +2158,32 @@ String RcbWifi::getIntanStatusInfo()
     return "Runt packet.";
 }
 
+void RcbWifi::flushLogs()
+{
+	for (auto device : rcbDevices)
+		device->flushLog();
+}
+
 String RcbWifi::getPacketInfo()
 {
-    float pdr = (float(hit)/float(seqNum)) * 100;
+	// editor shows the primary device, the aggregator devices are summed into the PDR
+	const RcbStreamCounts counts = rcbDevices[0]->getCounts();
+	const RcbPacketRing& ring = rcbDevices[0]->packetRing;
+	uint64_t allHit = 0, allSent = 0;
+	for (auto dev : rcbDevices)
+	{
+		// hit + miss rather than seqNum, which starts over when an RCB restarts
+		const RcbStreamCounts devCounts = dev->getCounts();
+		allHit += devCounts.hit;
+		allSent += devCounts.hit + devCounts.miss;
+	}
+
+    float pdr = allSent > 0 ? (float(allHit)/float(allSent)) * 100 : 0.0f;
     //LOGD("[dspw] PDR = ",String((pdr), 2));
     packetInfo = ("Packet PDR: " + String(pdr, 3) + "%");
-    packetInfo.append(("\nSQ N-" + String(seqNum)), 100);
-	packetInfo.append(("\nGood-" + String(hit)), 100);
-	packetInfo.append(("\nMiss-" + String(miss)), 100);
+    packetInfo.append(("\nSQ N-" + String(counts.seqNum)), 100);
+	packetInfo.append(("\nGood-" + String(counts.hit) + "  Ring-" + String(ring.getHighWaterMark())), 100);
+	packetInfo.append(("\nMiss-" + String(counts.miss) + "  Ovf-" + String(ring.getOverflowCount())), 100);
 	return packetInfo;
 }
 
@@ -900,7 +2194,7 @@ String RcbWifi::getBatteryInfo()
     //float b = (0xfff & (batteryVolts >> 2)) * 1.467 / 4096 * 62.0 / 15.0; //correct for 320k,150k,150k
     
     // for RCB-W24B-LVDS v1, RCB-W24C v1, RCB-W24A v2
-    float battV = (0xfff & (batteryVolts >> 2)) * 1.467 / 4096 * 40.0 / 9.75;  //correct for 200k,100k,100k
+    float battV = (0xfff & (rcbDevices[0]->batteryVolts >> 2)) * 1.467 / 4096 * 40.0 / 9.75;  //correct for 200k,100k,100k
     batteryInit = battV;
     
     if (battV > BATT_STREAM_THRESH)
@@ -930,31 +2224,8 @@ String RcbWifi::getBatteryInfo()
             "OK", 0);
     }
 	//Reset Battery Voltage
-	batteryVolts = 0;
+	rcbDevices[0]->batteryVolts = 0;
 	return batteryInfo;
 }
 
-// taken from Juce network demo 
-String RcbWifi::getResultText(const URL& url)
-{
-	StringPairArray responseHeaders;
-	int statusCode = 0;
-
-	std::unique_ptr<InputStream> urlStream = url.createInputStream(false, nullptr, nullptr, String(), 3000, &responseHeaders, &statusCode);
-
-	if (urlStream != nullptr)
-	{
-		return (statusCode != 0 ? "Status code: " + String(statusCode) + "\n" : String())
-			+ "Response headers: " + "\n"
-			+ responseHeaders.getDescription() + "\n"
-			+ "----------------------------------------------------" + "\n"
-			+ urlStream->readEntireStreamAsString();
-	}
-
-	if (statusCode != 0)
-		return "Failed to connect, status code = " + String(statusCode);
-
-	return "Failed to connect!";
-}
-
 
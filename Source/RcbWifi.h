@@ -28,10 +28,17 @@
 #include <DataThreadHeaders.h>
 
 #include <list>
+#include <map>
 #include <vector>
 #include <string>
 #include <iostream>
 
+#include "RcbControlClient.h"
+#include "RcbDevice.h"
+#include "RcbReceiver.h"
+#include "RcbReplay.h"
+#include "RcbScheduling.h"
+
 // These consts will eventually be options located in a visulizer window.
 // from ephysSocket
 const int DEFAULT_PORT = 51234; //4416;
@@ -45,6 +52,9 @@ const int DEFAULT_NUM_CHANNELS = 32;
 const float BATT_INIT_THRESH = 3.7;
 const float BATT_STREAM_THRESH = 3.7;
 
+// Connect and response timeout of the stream OFF sent on exit, so it fits the control client's shutdown wait
+const int RCB_SHUTDOWN_REQUEST_TIMEOUT_MS = 400;
+
 // Factory Test mode.  Allows RCB streaming without Intan RHD.
 // Or is this the prefered behavior. Always allow streaming regardless of Intan connected.
 const bool FACTORY_TEST_MODE = 1;
@@ -59,6 +69,14 @@ const String PLUGIN_VERSION = "v0.1.3";
 
 namespace RcbWifiNode
 {
+    /** Which init tokens the Initialize button sends */
+    enum class RcbInitMode
+    {
+        FULL,       // every token, every time
+        DIFF,       // only the tokens that changed since the RCB last acknowledged them
+        COMBINED    // as DIFF, joined into one POST
+    };
+
     class RcbWifi : public DataThread   //, public Timer
     {
 
@@ -89,9 +107,12 @@ namespace RcbWifiNode
         /** Resizes buffers when input parameters are changed*/
         void resizeBuffers() override;
 
-        /** Attempts to reconnect to the socket */
+        /** Attempts to reconnect the sockets of all devices */
         void tryToConnect();
 
+        /** Writes the log entries queued by the streaming path. Call from the message thread */
+        void flushLogs();
+
         /** Network stream parameters (must match features of incoming data) */
         int port = 0;
         float sample_rate = 0;
@@ -126,7 +147,9 @@ namespace RcbWifiNode
         bool isGoodRCB = false;
         bool initPassed = false;
 
-        String getIntanStatusInfo();
+        /** Fetches the RCB status page without blocking, done gets the result of getIntanStatusInfo() on the message thread */
+        void requestIntanStatus(std::function<void(String)> done);
+        String getIntanStatusInfo(const String& result);
         String batteryStatusInfo;
         String rhdStatusInfo;
         String getPacketInfo();
@@ -134,11 +157,107 @@ namespace RcbWifiNode
         String getBatteryInfo();
         String batteryInfo;
 
-        void setRCBTokens();
+        /** Sends the init tokens to every RCB, done is called on the message thread once all have answered */
+        void setRCBTokens(std::function<void(bool)> done = nullptr);
      
         float updateSampleRate();
+        float updateSampleRate(int numChannels, uint32_t& spiBitrate);
         void getMuxAdcBias(float sampleRate);
         double setDspCutoffFreq(double newDspCutoffFreq, float sampleRate);
+
+        /** Aggregator devices streamed alongside the one set up in the editor, as "ip:port:channels:start,..." */
+        String getExtraDevices();
+        String setExtraDevices(String devicesStr);
+
+        /** Packet loss concealment mode of all devices, OFF, ZERO, HOLD or LINEAR */
+        String getConcealMode();
+        String setConcealMode(String modeStr);
+
+        /** Which init tokens are sent, FULL, DIFF or COMBINED */
+        String getInitMode();
+        String setInitMode(String modeStr);
+
+        /** Init mode and what the last init sent to each device */
+        String getInitInfo();
+
+        /** Reorder window of all devices, in packets or in ms with an "ms" suffix, at most RCB_MAX_REORDER_PACKETS. Returns the window or "Invalid ..." */
+        String getReorderWindow();
+        String setReorderWindow(String windowStr);
+
+        /** Reorder window and depth distribution of each device */
+        String getReorderInfo();
+
+        /** Recovered sample clock drift and jitter of each device */
+        String getClockInfo();
+
+        /** Control request counts and round trip times of each device */
+        String getControlInfo();
+
+        /** Packet counts, clock fit and timing histograms of each device, as one JSON object */
+        String getStats();
+
+        /** Capture of every received packet from the next start, path "OFF" stops.  An empty segment size is the default */
+        String setCapture(String path, String segmentStr);
+        String getCaptureInfo();
+
+        /** Replay of a capture file instead of the RCBs from the next start, path "OFF" goes back to the RCBs */
+        void setReplay(String path, bool realTime);
+        String getReplayInfo();
+
+        /** Priority of the socket reader thread and the DataThread, NORMAL, HIGH or REALTIME */
+        String getThreadPriority();
+        String setThreadPriority(String priorityStr);
+
+        /** CPUs the socket reader thread and the DataThread are pinned to, as "receiver[,DataThread]", or OFF */
+        String getAffinity();
+        String setAffinity(String cpuStr);
+
+        /** Socket receive buffer asked for at start, kB, 0 leaves the OS default */
+        String getReceiveBufferSize();
+        String setReceiveBufferSize(String sizeStr);
+
+        /** Scheduling settings and what the OS granted the threads and sockets at the last start */
+        String getSchedulingInfo();
+
+        /** On-host high-pass and line noise notch of the amplifier channels, as "HPF 300 Hz order 2, NOTCH 60 Hz x3" or OFF */
+        String getFilter();
+        String setFilter(String filterStr, String valueStr, String extraStr);
+        const RcbFilterSettings& getFilterSettings() const { return filterSettings; }
+        void setFilterSettings(const RcbFilterSettings& settings);
+
+        /** Re-referencing of the amplifier channels, as "CAR 1-16" or "MEDIAN all" or OFF */
+        String getReference();
+        String setReference(String modeStr, String channelsStr);
+
+        /** Spike detection on the amplifier channels after the filters, as "4.5 x noise, 24 samples refractory" or OFF */
+        String getSpikeDetection();
+        String setSpikeDetection(String thresholdStr, String refractoryStr);
+        const RcbSpikeSettings& getSpikeSettings() const { return spikeSettings; }
+        void setSpikeSettings(const RcbSpikeSettings& settings);
+
+        /** Spike detection settings and the spike count and threshold of each channel */
+        String getSpikeInfo();
+
+        /** Debounce of the RCB digital inputs, as "2 ms" or OFF */
+        String getTtlDebounce();
+        String setTtlDebounce(String msStr);
+
+        /** Debounce and the edge count and last edge sample of each active digital input of each device */
+        String getTtlInfo();
+
+        /** Rate of the decimated LFP stream published next to each device's stream, as "1000 Hz" or OFF */
+        String getLfp();
+        String setLfp(String rateStr);
+
+        /** LFP setting and each device's actual LFP rate and filter delay */
+        String getLfpInfo();
+
+        /** NORMAL waits for packets, LOW busy polls for them on both streaming threads */
+        String getLatencyMode();
+        String setLatencyMode(String modeStr);
+
+        /** Latency mode and receive to DataBuffer latency of each device */
+        String getLatencyInfo();
         
     private:
 
@@ -151,62 +270,120 @@ namespace RcbWifiNode
         /** Stops thread */
         bool stopAcquisition()  override; 
 
-        /** Sample index counter */
-        int64 total_samples = 0;
+        /**
+            RCB modules streaming to this plugin, one DataStream each. Device 0 is the one
+            set up in the editor; any others are aggregator devices added with setExtraDevices().
+        */
+        OwnedArray<RcbDevice> rcbDevices;
+
+        /** Re-referencing, applied to every device. Bit c of the mask is channel c + 1 of each device, 0 is all */
+        RcbReferenceMode referenceMode = RcbReferenceMode::OFF;
+        uint32_t referenceMask = 0;
+        const StringArray referenceModeNames = { "OFF", "CAR", "MEDIAN" };
+
+        /** On-host filters, applied to every device */
+        RcbFilterSettings filterSettings;
+
+        /** Digital input debounce, ms, applied to every device */
+        float ttlDebounceMs = 0;
+
+        /** LFP stream rate asked for, Hz, 0 for none.  Each device decimates by the nearest integer factor */
+        float lfpRate = 0;
+        int getLfpFactor(const RcbDevice* device) const;
 
-        /** Local event state variable */
-        uint64 eventState = 0;
+        /** Spike detection, applied to every device */
+        RcbSpikeSettings spikeSettings;
 
-        /** True if socket is connected */
+        /** How lost packets are filled in, applied to every device */
+        RcbConcealMode concealMode = RcbConcealMode::ZERO;
+        const StringArray concealModeNames = { "OFF", "ZERO", "HOLD", "LINEAR" };
+
+        /** Reorder window, one of these is 0 */
+        int reorderPackets = 4;
+        float reorderMs = 0;
+
+        /** Sets the device reorder window from reorderPackets or reorderMs at its packet rate */
+        void applyReorderWindow(RcbDevice* device);
+
+        /** Copies the editor settings into device 0 */
+        void updatePrimaryDevice();
+
+        /** True if the sockets of all devices are bound */
         bool connected = false;
 
-        /** UPD socket object */
-        std::unique_ptr<DatagramSocket> socket;
+        /** False if resizeBuffers() could not allocate the streaming buffers of every device */
+        bool buffersAllocated = true;
+
+        /** Socket reader thread for all devices, runs while acquiring */
+        std::unique_ptr<RcbReceiver> receiver;
+
+        /** Capture written by the socket reader thread, empty path when off */
+        String capturePath;
+        int64 captureSegmentBytes = RCB_CAPTURE_SEGMENT_BYTES;
+        std::unique_ptr<RcbCaptureWriter> capture;
+        void startCapture();
+
+        /** Replay that stands in for the socket reader thread, empty path when off */
+        String replayPath;
+        bool replayRealTime = true;
+        std::unique_ptr<RcbReplay> replay;
+        bool startReplay();
 
-        /** Internal buffers */
-        uint16_t* recvbuf;
-        float* convbuf;
-        uint16_t* auxbuf;
+        /** Scheduling of the streaming threads and socket buffers, applied at start */
+        RcbThreadPriority threadPriority = RcbThreadPriority::HIGH;
+        const StringArray threadPriorityNames = { "NORMAL", "HIGH", "REALTIME" };
+        int receiverCpu = -1;
+        int dataThreadCpu = -1;
+        int receiveBufferKB = RCB_DEFAULT_RCVBUF_KB;
+
+        /** Busy polling on the socket reader thread and the DataThread, applied at start */
+        bool lowLatency = false;
+        RcbSpinWait dataThreadSpin;
+
+        /** The DataThread schedules itself on its first updateBuffer() of each acquisition */
+        bool dataThreadScheduled = false;
+        CriticalSection schedulingLock;
+        String dataThreadSchedulingInfo;
+        String receiverSchedulingInfo;
+
+        /** Init tokens for one RCB module */
+        StringArray getDeviceTokens(const String& hostStr, int numChannels, int chStart, uint32_t spiBitrate, float sampleRate);
+
+        RcbInitMode initMode = RcbInitMode::DIFF;
+        const StringArray initModeNames = { "FULL", "DIFF", "COMBINED" };
+
+        /**
+            Last token values each RCB acknowledged, by RCB IP and token name, e.g. "__SL_P_UPA".
+            Dropped when an RCB stops answering, since it may have lost its settings.
+        */
+        std::map<String, StringPairArray> appliedTokens;
+
+        /** Tokens sent by the last init, by RCB IP, as "sent of total" */
+        StringPairArray lastInitSent;
+
+        /** The tokens whose values differ from appliedTokens, all of them in FULL mode */
+        StringArray getChangedTokens(const String& rcbIpStr, const StringArray& tokens);
+
+        /** Records the token values the RCB acknowledged, tokens may be joined by & */
+        void setAppliedTokens(const String& rcbIpStr, const String& tokens);
+
+        /** Sends the HTTP requests to the RCBs off the message thread */
+        std::unique_ptr<RcbControlClient> control;
         
         // Intan RHD stuff
         int numAmps = 0;
         String chipId = "";
         
-        void sendRCBTriggerPost(String ipNumStr, String msgStr);
-        String getResultText(const URL& url);
-
-        Array<int64> sampleNumbers;
-        Array<double> timestamps; 
-        Array<uint64> ttlEventWords; 
-
-        // used by URL Post
-        StringPairArray responseHeaders;
-        
-        // UDP Packet
-        uint8_t magicNum = 0;
-        uint32_t seqNum = 0;
-        uint32_t nextsn = 0;
-        uint32_t hit = 0;
-        uint32_t miss = 0;
-        uint32_t delayed = 0;
-        uint16_t digInputs = 0;
-        uint16_t sod = 0;
-        bool firstPacket = 1;
+        /** Queues one POST. Without done, a failure clears initPassed and shows an alert */
+        void sendRCBTriggerPost(String ipNumStr, String msgStr, std::function<void(bool)> done = nullptr);
         
         // battery status
         float batteryInit = 0;
-        uint16_t batteryVolts = 0;
-        
-        uint8_t auxPhase = 0;
-        uint8_t auxMask = 0;
         
         uint32_t bitrate = 0;
         int numChannelsEnabled = 0;
         int intanAlertNum = 0;  //might not need this
         
-        int recvBufSize;// = 40 + (((num_channels + 2) * num_samp) * 2);
-        int convBufSize;// = 0 + (((num_channels) * num_samp) * 4);
-        
         // for RHD register definitions please see Intan RHD2000 data sheet.
         // default values below, many will not change, Bandwidth and Bias will change
 
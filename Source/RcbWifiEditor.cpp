@@ -356,11 +356,15 @@ void RcbWifiEditor::timerCallback(int timerID)
 	if (timerID == 1)
 	{
 		seqNumLabel->setText(node->getPacketInfo(), dontSendNotification);
+		node->flushLogs();
 
 		if (timeInt == 0)
 		{
 			node->getBatteryInfo();
 			batteryLabel->setText(node->batteryInfo, dontSendNotification);
+
+			// what the OS granted the streaming threads and sockets, and the latency they give
+			seqNumLabel->setTooltip(node->getSchedulingInfo() + "\n" + node->getLatencyInfo());
             
             if (node->isGoodRCB == false)
                 initButton->setLabel("Init");
@@ -373,35 +377,43 @@ void RcbWifiEditor::timerCallback(int timerID)
     // timer 2 is used when not streaming data.  checks that RCB is still alive on network and updates battery voltage display.
 	}else if (timerID == 2)
     {
-        //first check that RCB init happens ok
-		String htmlStatus =	node->getIntanStatusInfo();
+        //first check that RCB init happens ok. the answer arrives in rcbStatusPolled()
+        Component::SafePointer<RcbWifiEditor> editor(this);
+        node->requestIntanStatus([editor](String htmlStatus)
+        {
+            if (editor != nullptr)
+                editor->rcbStatusPolled();
+        });
+	}
+}
 
-		if (node->isGoodRCB == true)
-		{
+void RcbWifiEditor::rcbStatusPolled()
+{
+	if (node->isGoodRCB == true)
+	{
+        rcbIsLost = 0;
+		rhdRegsLabel->setText(node->rhdStatusInfo, dontSendNotification);
+		batteryLabel->setText(node->batteryStatusInfo, dontSendNotification);
+		return;
+	}
+	else
+	{
+        // Give RCB more than one network status poll to respond it is alive
+        if (rcbIsLost > 1)
+        {
+            stopTimer(2);
+            CoreServices::setAcquisitionStatus(false);
+            initButton->setLabel("Init");
             rcbIsLost = 0;
-			rhdRegsLabel->setText(node->rhdStatusInfo, dontSendNotification);
-			batteryLabel->setText(node->batteryStatusInfo, dontSendNotification);
-			return;
-		}
-		else
-		{
-            // Give RCB more than one network status poll to respond it is alive
-            if (rcbIsLost > 1)
-            {
-                stopTimer(2);
-                CoreServices::setAcquisitionStatus(false);
-                initButton->setLabel("Init");
-                rcbIsLost = 0;
-                node->initPassed = false;
-                
-                AlertWindow::showMessageBox(AlertWindow::NoIcon,
-                    "RCB-LVDS Module not found at IP address " + node->ipNumStr,
-                    "Please check RCB IP Address setting,\nWiFi router configuration,\nand RCB battery power.\r\n\r\n"
-                    "Press Initialize button to try again.",
-                    "OK", 0);
-            }
-            rcbIsLost++;
-		}
+            node->initPassed = false;
+            
+            AlertWindow::showMessageBox(AlertWindow::NoIcon,
+                "RCB-LVDS Module not found at IP address " + node->ipNumStr,
+                "Please check RCB IP Address setting,\nWiFi router configuration,\nand RCB battery power.\r\n\r\n"
+                "Press Initialize button to try again.",
+                "OK", 0);
+        }
+        rcbIsLost++;
 	}
 }
 
@@ -439,6 +451,136 @@ void RcbWifiEditor::stopAcquisition()
 
 }
 
+void RcbWifiEditor::intanStatusReceived(String htmlStatus)
+{
+    // back from "Wait" on every early exit below, only sending the tokens shows "Wait" again
+    initButton->setEnabled(true);
+    initButton->setLabel("Init");
+
+    LOGD("[dspw] htmlStatus -  ", htmlStatus);
+    batteryLabel->setText(node->batteryStatusInfo, dontSendNotification);
+    if (node->isGoodRCB == true)
+    {
+        //batteryLabel->setText(node->batteryStatusInfo, dontSendNotification);
+        
+        // send stop stream command in case it is alreadry started ?
+        
+        //then report if intan rhd is working ok
+        rhdRegsLabel->setText(node->rhdStatusInfo, dontSendNotification);
+        
+        // if Intan RHD is good then continue setup.  but why do we care?
+        if (node->isGoodIntan == true || FACTORY_TEST_MODE == 1)
+        {
+            // set up rf pa attn
+            node->rcbPaStr = paPwrCbox->getText();
+            
+            // get number of channels from dropdown box
+            int num_channels = chanCbox->getText().getIntValue();
+            node->num_channels = num_channels;
+            
+            // get channel start number from label
+            int chShift = chStartNumLabel->getText().getIntValue();
+            node->chShift = chShift;
+            
+            if (chShift + (num_channels - 1) > 32)
+            {
+                AlertWindow::showMessageBox(AlertWindow::NoIcon,
+                    "Channel Start Number value " + String(chShift) + " is not valid \r\n"
+                    "when Number of Channels is " + String(num_channels) + ". \r\n"
+                    "Combination must be between 1 and 33.",
+                    "Please check your Channel settings. \r\n"
+                    "",
+                    "OK", 0);
+            
+                return;
+            }
+            
+            // get number of samples in each packet
+            // total number of 16-bit samples in UDP packet is numTs * (num chan + aux)
+            // used to compute size of recbuf and convbuff
+            int rhdNumTsItems = chanCbox->getSelectedItemIndex();
+            node->num_samp = RCB_SAMPLES_PER_PACKET[rhdNumTsItems];
+            
+            // get desired sample rate from combo box
+            node->desiredSampleRate = fsCbox->getText().getFloatValue();
+            node->sample_rate = node->updateSampleRate();
+            
+            // get RHD AUX enable state.  will affect resize buffers
+            node->auxEnableState = auxEnableButton->getToggleState();
+            
+            // update signal chain with new actual sample rate and number of channels
+            CoreServices::updateSignalChain(this);
+            
+            // get mux and ADC bias.  depends on actual sample rate.
+            node->getMuxAdcBias(node->sample_rate);
+            
+            // get DSP HPF value and enable state
+            node->dspHpfValue = dspCutNumLabel->getText().getFloatValue();
+            node->dspHpfState = dspOffsetButton->getToggleState();
+            float dspHpfCut = node->setDspCutoffFreq(dspCutNumLabel->getText().getFloatValue(), node->sample_rate);
+            //LOGD("[dspw] MY dspCut = ",dspHpfCut);
+            std::stringstream stream;
+            stream << std::fixed << std::setprecision(1) << dspHpfCut;
+            std::string s = stream.str();
+            dspCutNumLabel->setText(s, dontSendNotification);
+            
+            // get upper BW filter from combo box
+            node->rhdUpBwInt = upBwCbox->getSelectedItemIndex();
+            
+            // get lower BW filter from combo box
+            node->rhdLowBwInt = lowBwCbox->getSelectedItemIndex();
+            
+            // develop correct RHD Register values and send them to each RCB.
+            // init continues in tokensSent() once all RCBs have answered
+            initButton->setLabel("Wait");
+            Component::SafePointer<RcbWifiEditor> editor(this);
+            node->setRCBTokens([editor](bool ok)
+            {
+                if (editor != nullptr)
+                    editor->tokensSent(ok);
+            });
+        }
+    }
+    else {
+        LOGD("[dspw] isGoodRCB = false");
+        AlertWindow::showMessageBox(AlertWindow::NoIcon,
+                                    "RCB-LVDS Module not found at IP address " + node->ipNumStr,
+                                    "Please check RCB IP Address setting,\nWiFi router configuration,\nand RCB battery power.\r\n\r\n"
+                                    "Press Initialize button to try again.",
+                                    "OK", 0);
+        return;
+    }
+}
+
+void RcbWifiEditor::tokensSent(bool ok)
+{
+    // if tokens are sent ok then RCB WiFi should be initialized!
+    node->initPassed = ok;
+    initButton->setLabel(ok ? "Ready" : "Init");
+
+    if (!ok)
+        return;
+
+    //Start poll rate timer.  pollRate comboBox value x 1 min
+    // poll rate timer is only active when NOT streaming data
+    // check pollrate comboBox value first
+
+    if (timer2Disable == false)
+    {
+        // get timer polling rate from comboBox
+        int pollRate = pollRateCbox->getText().getIntValue();
+
+        timer2Rate = pollRate;
+
+        startTimer(2, timer2Rate * 60000);
+        LOGD("[dspw] timer poll rate = ",String(int(timer2Rate))," sec");
+    }else
+    {
+        //stopTimer(2);
+        LOGD("[dspw] timer poll rate = OFF");
+    }
+}
+
 IPAddress RcbWifiEditor::getCurrentIpAddress()
 {
 	Array<IPAddress> ipAddresses;
@@ -488,116 +630,17 @@ void RcbWifiEditor::buttonClicked(Button* button)
                 // set up host string with ip and port
                 node->myHostStr = hostStr + ":" + portNumLabel->getText();
                 
-                //first check that RCB exists on network, get battery voltage
-                String htmlStatus = node->getIntanStatusInfo();
-                LOGD("[dspw] htmlStatus -  ", htmlStatus);
-                batteryLabel->setText(node->batteryStatusInfo, dontSendNotification);
-                if (node->isGoodRCB == true)
+                //first check that RCB exists on network, get battery voltage.
+                // the status page is fetched in the background, init continues in intanStatusReceived()
+                initButton->setLabel("Wait");
+                initButton->setEnabled(false);
+
+                Component::SafePointer<RcbWifiEditor> editor(this);
+                node->requestIntanStatus([editor](String htmlStatus)
                 {
-                    //batteryLabel->setText(node->batteryStatusInfo, dontSendNotification);
-                    
-                    // send stop stream command in case it is alreadry started ?
-                    
-                    //then report if intan rhd is working ok
-                    rhdRegsLabel->setText(node->rhdStatusInfo, dontSendNotification);
-                    
-                    // if Intan RHD is good then continue setup.  but why do we care?
-                    if (node->isGoodIntan == true || FACTORY_TEST_MODE == 1)
-                    {
-                        // set up rf pa attn
-                        node->rcbPaStr = paPwrCbox->getText();
-                        
-                        // get number of channels from dropdown box
-                        int num_channels = chanCbox->getText().getIntValue();
-                        node->num_channels = num_channels;
-                        
-                        // get channel start number from label
-                        int chShift = chStartNumLabel->getText().getIntValue();
-                        node->chShift = chShift;
-                        
-                        if (chShift + (num_channels - 1) > 32)
-                        {
-                            AlertWindow::showMessageBox(AlertWindow::NoIcon,
-                                "Channel Start Number value " + String(chShift) + " is not valid \r\n"
-                                "when Number of Channels is " + String(num_channels) + ". \r\n"
-                                "Combination must be between 1 and 33.",
-                                "Please check your Channel settings. \r\n"
-                                "",
-                                "OK", 0);
-                        
-                            return;
-                        }
-                        
-                        // get number of samples in each packet
-                        // used to compute size of recbuf and convbuff
-                        int rhdNumTsItems = chanCbox->getSelectedItemIndex();
-                        node->num_samp = numTsItems[rhdNumTsItems];
-                        
-                        // get desired sample rate from combo box
-                        node->desiredSampleRate = fsCbox->getText().getFloatValue();
-                        node->sample_rate = node->updateSampleRate();
-                        
-                        // get RHD AUX enable state.  will affect resize buffers
-                        node->auxEnableState = auxEnableButton->getToggleState();
-                        
-                        // update signal chain with new actual sample rate and number of channels
-                        CoreServices::updateSignalChain(this);
-                        
-                        // get mux and ADC bias.  depends on actual sample rate.
-                        node->getMuxAdcBias(node->sample_rate);
-                        
-                        // get DSP HPF value and enable state
-                        node->dspHpfValue = dspCutNumLabel->getText().getFloatValue();
-                        node->dspHpfState = dspOffsetButton->getToggleState();
-                        float dspHpfCut = node->setDspCutoffFreq(dspCutNumLabel->getText().getFloatValue(), node->sample_rate);
-                        //LOGD("[dspw] MY dspCut = ",dspHpfCut);
-                        std::stringstream stream;
-                        stream << std::fixed << std::setprecision(1) << dspHpfCut;
-                        std::string s = stream.str();
-                        dspCutNumLabel->setText(s, dontSendNotification);
-                        
-                        // get upper BW filter from combo box
-                        node->rhdUpBwInt = upBwCbox->getSelectedItemIndex();
-                        
-                        // get lower BW filter from combo box
-                        node->rhdLowBwInt = lowBwCbox->getSelectedItemIndex();
-                        
-                        // develop correct RHD Register values and create string
-                        node->setRCBTokens();
-                        
-                        // if tokens are sent ok then RCB WiFi should be initialized!
-                        node->initPassed = true;
-                        initButton->setLabel("Ready");
-                        
-                        //Start poll rate timer.  pollRate comboBox value x 1 min
-                        // poll rate timer is only active when NOT streaming data
-                        // check pollrate comboBox value first
-                        
-                        if (timer2Disable == false)
-                        {
-                            // get timer polling rate from comboBox
-                            int pollRate = pollRateCbox->getText().getIntValue();
-                           
-                            timer2Rate = pollRate;
-                            
-                            startTimer(2, timer2Rate * 60000);
-                            LOGD("[dspw] timer poll rate = ",String(int(timer2Rate))," sec");
-                        }else
-                        {
-                            //stopTimer(2);
-                            LOGD("[dspw] timer poll rate = OFF");
-                        }
-                    }
-                }
-                else {
-                    LOGD("[dspw] isGoodRCB = false");
-                    AlertWindow::showMessageBox(AlertWindow::NoIcon,
-                                                "RCB-LVDS Module not found at IP address " + node->ipNumStr,
-                                                "Please check RCB IP Address setting,\nWiFi router configuration,\nand RCB battery power.\r\n\r\n"
-                                                "Press Initialize button to try again.",
-                                                "OK", 0);
-                    return;
-                }
+                    if (editor != nullptr)
+                        editor->intanStatusReceived(htmlStatus);
+                });
             }
             else
             {
@@ -817,7 +860,7 @@ void RcbWifiEditor::comboBoxChanged(ComboBox* comboBoxThatHasChanged)
         // get number of samples in each packet
         // used to compute size of recbuf and convbuff
         int rhdNumTsItems = chanCbox->getSelectedItemIndex();
-        node->num_samp = numTsItems[rhdNumTsItems];
+        node->num_samp = RCB_SAMPLES_PER_PACKET[rhdNumTsItems];
         node->sample_rate = node->updateSampleRate();
         CoreServices::updateSignalChain(this);
             
@@ -894,6 +937,24 @@ void RcbWifiEditor::saveCustomParametersToXml(XmlElement* xmlNode)
 	parameters->setAttribute("paPwr", paPwrCbox->getSelectedItemIndex());
     parameters->setAttribute("pollRate", pollRateCbox->getSelectedItemIndex());
     parameters->setAttribute("auxEnBut", auxEnableButton->getToggleState());
+    parameters->setAttribute("extraDevices", node->getExtraDevices());
+    parameters->setAttribute("conceal", node->getConcealMode());
+    parameters->setAttribute("reorder", node->getReorderWindow());
+    parameters->setAttribute("initMode", node->getInitMode());
+    parameters->setAttribute("priority", node->getThreadPriority());
+    parameters->setAttribute("affinity", node->getAffinity());
+    parameters->setAttribute("rcvbuf", node->getReceiveBufferSize());
+    parameters->setAttribute("latency", node->getLatencyMode());
+    parameters->setAttribute("reference", node->getReference());
+    parameters->setAttribute("filterHpf", node->getFilterSettings().highPassHz);
+    parameters->setAttribute("filterHpfOrder", node->getFilterSettings().highPassOrder);
+    parameters->setAttribute("filterNotch", node->getFilterSettings().notchHz);
+    parameters->setAttribute("filterNotchHarmonics", node->getFilterSettings().notchHarmonics);
+    parameters->setAttribute("ttlDebounce", node->getTtlDebounce());
+    parameters->setAttribute("lfp", node->getLfp());
+    parameters->setAttribute("spikes", node->getSpikeSettings().enabled);
+    parameters->setAttribute("spikeThreshold", node->getSpikeSettings().thresholdK);
+    parameters->setAttribute("spikeRefractory", node->getSpikeSettings().refractorySamples);
 
 }
 
@@ -916,6 +977,33 @@ void RcbWifiEditor::loadCustomParametersFromXml(XmlElement* xmlNode)
 			paPwrCbox->setSelectedItemIndex(subNode->getIntAttribute("paPwr", 5), dontSendNotification);
             pollRateCbox->setSelectedItemIndex(subNode->getIntAttribute("pollRate", 0), dontSendNotification);
             auxEnableButton->setToggleState(subNode->getBoolAttribute("auxEnBut", false), dontSendNotification);
+            node->setExtraDevices(subNode->getStringAttribute("extraDevices", "NONE"));
+            node->setConcealMode(subNode->getStringAttribute("conceal", "ZERO"));
+            node->setReorderWindow(subNode->getStringAttribute("reorder", "4"));
+            node->setInitMode(subNode->getStringAttribute("initMode", "DIFF"));
+            node->setThreadPriority(subNode->getStringAttribute("priority", "HIGH"));
+            node->setAffinity(subNode->getStringAttribute("affinity", "OFF"));
+            node->setReceiveBufferSize(subNode->getStringAttribute("rcvbuf", String(RCB_DEFAULT_RCVBUF_KB)));
+            node->setLatencyMode(subNode->getStringAttribute("latency", "NORMAL"));
+
+            StringArray reference = StringArray::fromTokens(subNode->getStringAttribute("reference", "OFF"), " ", "");
+            node->setReference(reference[0], reference[1]);
+
+            RcbFilterSettings filterSettings;
+            filterSettings.highPassHz = (float)subNode->getDoubleAttribute("filterHpf", 0);
+            filterSettings.highPassOrder = subNode->getIntAttribute("filterHpfOrder", 2);
+            filterSettings.notchHz = (float)subNode->getDoubleAttribute("filterNotch", 0);
+            filterSettings.notchHarmonics = subNode->getIntAttribute("filterNotchHarmonics", 1);
+            node->setFilterSettings(filterSettings);
+
+            node->setTtlDebounce(subNode->getStringAttribute("ttlDebounce", "OFF").upToFirstOccurrenceOf(" ", false, false));
+            node->setLfp(subNode->getStringAttribute("lfp", "OFF").upToFirstOccurrenceOf(" ", false, false));
+
+            RcbSpikeSettings spikeSettings;
+            spikeSettings.enabled = subNode->getBoolAttribute("spikes", false);
+            spikeSettings.thresholdK = (float)subNode->getDoubleAttribute("spikeThreshold", 4.5);
+            spikeSettings.refractorySamples = subNode->getIntAttribute("spikeRefractory", 24);
+            node->setSpikeSettings(spikeSettings);
 
 		}
 	}
@@ -156,11 +156,13 @@ namespace RcbWifiNode
         IPAddress getCurrentIpAddress();
         IPAddress myHost;
 
-        // total number of 16-bit samples in UDP packet is numTs * (num chan + aux)
-        int numTsItems[8] = { 21, 23, 27, 32, 39, 51, 71, 119 }; // numCh[32, 28, 24,20, 16, 12, 8, 4];
-        
         //count how many RCB Timer2 polling events are lost
         int rcbIsLost = 0;
+        void rcbStatusPolled();
+
+        // Init button steps, called when the RCB control requests complete
+        void intanStatusReceived(String htmlStatus);
+        void tokensSent(bool ok);
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RcbWifiEditor);
     };